@@ -4,7 +4,7 @@
 #include <fstream>       // std::fstream
 #include <sstream>       // std::stringstream
 #include <string>        // std::string
-#include <algorithm>     // std::find_if, std::ptr_fun
+#include <algorithm>     // std::find_if, std::ptr_fun, std::stable_sort
 #include <iostream>      // std::cout, std::endl
 
 
@@ -12,6 +12,19 @@ address_map::address_map( index_type slaves, const char* filename )
     : entries( slaves )
 {
     std::fstream mem_map( filename );
+    load( mem_map );
+}
+
+address_map::address_map( index_type slaves, std::istream& mem_map )
+    : entries( slaves )
+{
+    load( mem_map );
+}
+
+void address_map::load( std::istream& mem_map )
+{
+    index_type slaves = entries.size();
+    std::vector<bool> mapped( slaves, false );
     std::string line;
 
     index_type i = 0, slave_start = 0, slave_end = 0;
@@ -39,6 +52,7 @@ address_map::address_map( index_type slaves, const char* filename )
             entries[i].end   = slave_end;
 
             entries[i].size  = 1U + ( slave_end - slave_start );
+            mapped[i] = true;
 
             std::cout << "Bus slave " << std::dec << i
                       << " starts 0x"   << std::hex << entries[i].start
@@ -48,34 +62,92 @@ address_map::address_map( index_type slaves, const char* filename )
             std::cout << std::dec;
         }
     }
+
+    build_index( mapped );
 }
 
 void address_map::swap( address_map & that )
 {
     that.entries.swap( entries );
+    that.index_start.swap( index_start );
+    that.index_slave.swap( index_slave );
 }
 
 
-struct address_map::in_range
+// orders slaves by the start address of their region
+struct address_map::by_start
 {
-    explicit in_range( address_type addr )
-    : addr( addr )
+    explicit by_start( const std::vector<entry>& entries )
+    : entries( entries )
     {}
 
-    bool operator()( const entry& e ) const
-    { return ( e.start <= addr ) && ( addr <= e.end ) ; }
+    bool operator()( index_type a, index_type b ) const
+    { return entries[a].start < entries[b].start; }
 
 private:
-    address_type addr;
+    const std::vector<entry>& entries;
 };
 
+void address_map::build_index( std::vector<bool> const & mapped )
+{
+    std::vector<index_type> order;
+    for( index_type i = 0; i < entries.size(); ++i ) {
+        if( !mapped[i] ) continue;
+
+        if( entries[i].end < entries[i].start ) {
+            std::cerr << "Bus ERROR: slave " << std::dec << i
+                      << " ends before it starts - ignored" << std::endl;
+            continue;
+        }
+        order.push_back( i );
+    }
+    std::stable_sort( order.begin(), order.end(), by_start( entries ) );
+
+    index_start.clear();
+    index_slave.clear();
+    index_start.reserve( order.size() );
+    index_slave.reserve( order.size() );
+
+    for( std::vector<index_type>::const_iterator it = order.begin();
+         it != order.end(); ++it )
+    {
+        const entry& e = entries[*it];
+
+        // regions are sorted by start, so only the previous one can
+        // overlap with the current one
+        if( !index_slave.empty() && e.start <= entries[index_slave.back()].end ) {
+            std::cerr << "Bus ERROR: slave " << std::dec << *it
+                      << " overlaps slave " << index_slave.back()
+                      << " at 0x" << std::hex << e.start
+                      << " - ignored" << std::dec << std::endl;
+            continue;
+        }
+        index_start.push_back( e.start );
+        index_slave.push_back( *it );
+    }
+}
+
 address_map::index_type address_map::decode( address_type addr ) const
 {
-    std::vector<entry>::const_iterator index
-        = std::find_if( entries.begin(), entries.end(), in_range(addr) );
+    if( index_start.empty() )
+        return npos;
+
+    // branch-free binary search for the last region starting at or
+    // before addr, the only candidate that can contain it
+    const address_type* base = &index_start[0];
+    std::size_t         len  = index_start.size();
+    while( len > 1 ) {
+        std::size_t half = len / 2;
+        base = ( base[half] <= addr ) ? base + half : base;
+        len -= half;
+    }
+
+    if( addr < *base )
+        return npos; // below first region
 
-    if( index != entries.end() )
-        return index - entries.begin();
+    index_type index = index_slave[ base - &index_start[0] ];
+    if( addr <= entries[index].end )
+        return index;
 
     return npos; // not found
 }
@@ -89,6 +161,15 @@ address_map::get_start_address(address_map::index_type index) const
     return entries[index].start;
 }
 
+address_map::address_type
+address_map::get_end_address(address_map::index_type index) const
+{
+    if(index >= this->size()) {
+        return npos; // not found
+    }
+    return entries[index].end;
+}
+
 address_map::address_type
 address_map::get_local_address(index_type index, address_type address) const
 {
@@ -101,4 +182,17 @@ address_map::get_global_address(index_type index, address_type address) const
     return address + get_start_address(index);
 }
 
+void
+address_map::get_global_range(index_type index, address_type& start,
+                              address_type& end) const
+{
+    address_type last = get_end_address(index) - get_start_address(index);
+
+    if(start > last) start = last;
+    if(end > last)   end   = last;
+
+    start = get_global_address(index, start);
+    end   = get_global_address(index, end);
+}
+
 /* vim: set ts=4 sw=4 tw=72 et :*/
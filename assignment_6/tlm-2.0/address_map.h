@@ -3,6 +3,7 @@
 #define ADDRESS_MAP_H_INCLUDED_
 
 #include <cstddef>
+#include <iosfwd>
 #include <vector>
 
 struct address_map {
@@ -12,14 +13,21 @@ struct address_map {
 
     address_map() : entries() {}
     address_map( index_type slaves, const char* filename );
+    address_map( index_type slaves, std::istream& mem_map );
 
     index_type decode( address_type ) const;
 
     address_type get_start_address(index_type index) const;
+    address_type get_end_address(index_type index) const;
 
     address_type get_local_address(index_type, address_type) const;
     address_type get_global_address(index_type, address_type) const;
 
+    // clip a local range [start,end] of a slave to its region and
+    // translate it to global addresses (e.g. for DMI regions)
+    void get_global_range(index_type, address_type& start,
+                          address_type& end) const;
+
     index_type operator()( address_type addr ) const
     { return decode( addr ); }
 
@@ -38,9 +46,17 @@ private:
         address_type end;
         size_type    size;
     };
-    struct in_range;
+    struct by_start;
+
+    void load( std::istream& mem_map );
+    void build_index( std::vector<bool> const & mapped );
 
     std::vector<entry> entries;
+
+    // decode index: start addresses of all mapped, non-overlapping
+    // regions in ascending order, and the slave owning each of them
+    std::vector<address_type> index_start;
+    std::vector<index_type>   index_slave;
 };
 
 #endif // ADDRESS_MAP_H_INCLUDED_
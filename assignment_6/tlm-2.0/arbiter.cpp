@@ -1,3 +1,275 @@
 #include "arbiter.h"
+#include "tracer.h"
 
-// FILLME: implement arbiter::b_transport
+#include <iostream> // std::cout, std::endl
+
+arbiter::arbiter( sc_core::sc_module_name /* unused */,
+                  double cycle, sc_core::sc_time_unit unit, policy p )
+: base_type()
+, init_socket("init_socket")
+, target_socket("target_socket")
+, cycle( cycle, unit )
+, arbitration( p )
+, weights()
+, pending()
+, queued()
+, owner( -1 )
+, last()
+, credits()
+, arbitrate_event()
+, granted()
+, decoupled()
+, schedule()
+, stats()
+, grants()
+, queue_sum()
+, queue_max()
+, target_stats()
+, init_stats()
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
+
+    SC_METHOD( arbitrate );
+    sensitive << arbitrate_event;
+    dont_initialize();
+
+    checkpoint::instance().add( name(), *this );
+}
+
+void arbiter::set_weight( unsigned port, unsigned weight )
+{
+    if( port >= weights.size() )
+        weights.resize( port + 1, 1 );
+    weights[port] = weight ? weight : 1;
+}
+
+unsigned arbiter::get_weight( unsigned port ) const
+{
+    return port < weights.size() ? weights[port] : 1;
+}
+
+void arbiter::end_of_elaboration()
+{
+    pending.resize( target_socket.size() );
+    stats.resize( target_socket.size() );
+
+    // a restored grant of a router that is not there
+    if( last >= target_socket.size() )
+        last = credits = 0;
+
+    decoupled = tlm::tlm_global_quantum::instance().get()
+             != sc_core::SC_ZERO_TIME;
+    if( decoupled && ( arbitration != round_robin || !weights.empty() ) )
+        SC_REPORT_WARNING( "Arbiter/Policy",
+                           "temporally decoupled accesses are served first "
+                           "come, first served, the policy and weights "
+                           "are ignored" );
+
+    target_stats.resize( target_socket.size() );
+    for( unsigned i = 0; i < target_stats.size(); ++i )
+        register_stats( *this, "target_socket", target_stats[i], i );
+    register_stats( *this, "init_socket", init_stats );
+}
+
+void arbiter::b_transport( int id,
+                           tlm::tlm_generic_payload& trans,
+                           sc_core::sc_time& delay )
+{
+    stats_scope router( target_stats[id], trans, delay );
+
+    // temporally decoupled initiators run ahead of the kernel, they
+    // cannot wait for each other's grants
+    if( decoupled ) {
+        transport_decoupled( id, trans, delay );
+        return;
+    }
+
+    {
+        trace_scope waiting( *this, "arbitrate", trans, delay );
+        acquire( id );
+    }
+
+    {
+        stats_scope slave( init_stats, trans, delay );
+        trace_scope granted( *this, "grant", trans, delay );
+        init_socket->b_transport( trans, delay );
+    }
+
+    release();
+}
+
+void arbiter::transport_decoupled( int id, tlm::tlm_generic_payload& trans,
+                                   sc_core::sc_time& delay )
+{
+    sc_core::sc_time arrival = sc_core::sc_time_stamp() + delay;
+    sc_core::sc_time start   = schedule.find( arrival, cycle );
+
+    ++stats[id].requests;
+    ++grants;
+    if( start > arrival ) {
+        ++stats[id].waits;
+        stats[id].blocked += start - arrival;
+    }
+
+    // granted one cycle after the gap starts
+    delay = start + cycle - sc_core::sc_time_stamp();
+    {
+        stats_scope slave( init_stats, trans, delay );
+        trace_scope granted( *this, "grant", trans, delay );
+        init_socket->b_transport( trans, delay );
+    }
+
+    // the slave is held until the access completes
+    sc_core::sc_time finish = sc_core::sc_time_stamp() + delay;
+    schedule.reserve( start, finish > start + cycle ? finish - start : cycle );
+}
+
+void arbiter::acquire( unsigned id )
+{
+    sc_core::sc_time requested = sc_core::sc_time_stamp();
+
+    pending[id] = true;
+    ++queued;
+    ++stats[id].requests;
+    ++grants;
+    queue_sum += queued;
+    if( queued > queue_max )
+        queue_max = queued;
+    init_stats.queue( queued );
+
+    // the slave is free, arbitrate after one cycle
+    if( owner < 0 )
+        arbitrate_event.notify( cycle );
+
+    while( owner != int( id ) )
+        wait( granted );
+
+    sc_core::sc_time waited = sc_core::sc_time_stamp() - requested;
+    if( waited > cycle ) {
+        ++stats[id].waits;
+        stats[id].blocked += waited - cycle;
+    }
+}
+
+void arbiter::release()
+{
+    owner = -1;
+    if( queued )
+        arbitrate_event.notify( cycle );
+}
+
+void arbiter::arbitrate()
+{
+    int next = select();
+    if( next < 0 || owner >= 0 )
+        return;
+
+    pending[next] = false;
+    --queued;
+    owner = next;
+    granted.notify();
+}
+
+int arbiter::select()
+{
+    const unsigned n = pending.size();
+    if( !queued )
+        return -1;
+
+    switch( arbitration ) {
+    case fixed_priority:
+        for( unsigned i = 0; i < n; ++i )
+            if( pending[i] )
+                return last = i;
+        break;
+
+    case weighted:
+        // keep granting the same router while it has credits left
+        if( credits && pending[last] ) {
+            --credits;
+            return last;
+        }
+        // fall through
+
+    case round_robin:
+        for( unsigned i = 1; i <= n; ++i ) {
+            unsigned candidate = ( last + i ) % n;
+            if( pending[candidate] ) {
+                last    = candidate;
+                credits = get_weight( candidate ) - 1;
+                return last;
+            }
+        }
+        break;
+    }
+    return -1;
+}
+
+bool arbiter::get_direct_mem_ptr( int /* id unused */,
+                                  tlm::tlm_generic_payload& trans,
+                                  tlm::tlm_dmi& dmi )
+{
+    return init_socket->get_direct_mem_ptr( trans, dmi );
+}
+
+void arbiter::invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                         sc_dt::uint64 end )
+{
+    // any router may hold a pointer into our slave
+    for( unsigned i = 0; i < target_socket.size(); ++i )
+        target_socket[i]->invalidate_direct_mem_ptr( start, end );
+}
+
+unsigned int arbiter::transport_dbg( int /* id unused */,
+                                    tlm::tlm_generic_payload& trans )
+{
+    return init_socket->transport_dbg( trans );
+}
+
+bool arbiter::save_state( state_type& state, const std::string& /* prefix unused */ )
+{
+    state.push_back( last );
+    state.push_back( credits );
+    state.push_back( grants );
+    state.push_back( queue_sum );
+    state.push_back( queue_max );
+    return true;
+}
+
+bool arbiter::restore_state( const state_type& state )
+{
+    if( state.size() != 5 )
+        return false;
+
+    last      = unsigned( state[0] );
+    credits   = unsigned( state[1] );
+    grants    = state[2];
+    queue_sum = state[3];
+    queue_max = unsigned( state[4] );
+    return true;
+}
+
+void arbiter::end_of_simulation()
+{
+    for( unsigned id = 0; id < stats.size(); ++id ) {
+        std::cout << name() << " router " << id
+                  << ": " << stats[id].requests << " requests, "
+                  << stats[id].waits << " grant waits, "
+                  << stats[id].blocked << " blocked"
+                  << std::endl;
+    }
+    // no queue under temporal decoupling, the busy time instead
+    if( decoupled )
+        std::cout << name() << ": " << grants << " grants, slave busy "
+                  << schedule.busy() << std::endl;
+    else
+        std::cout << name() << " queue depth: "
+                  << ( grants ? double( queue_sum ) / grants : 0. )
+                  << " average, " << queue_max << " max"
+                  << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -6,7 +6,136 @@
 #include <tlm_utils/simple_initiator_socket.h>
 #include <tlm_utils/multi_passthrough_target_socket.h>
 
-// FILLME: implement arbiter module, starting from bus_cx
+#include "checkpoint.h"
+#include "stats.h"
+#include "timeline.h"
+
+#include <vector>
+
+// Arbitration component: serialises the accesses of all routers to
+// a single slave
+//
+// Requests arriving while the slave is free are granted after one
+// arbitration cycle, together with all requests arriving in the
+// meantime.  The policy selects among the pending routers, identified
+// by the index of their binding to target_socket:
+//  - round_robin:    the next pending router after the last granted
+//  - fixed_priority: the pending router with the lowest index
+//  - weighted:       round robin, but router i keeps the grant for up
+//                    to weight(i) consecutive accesses
+//
+// Temporally decoupled routers (a global quantum above zero) arrive
+// ahead of the kernel and out of order, so they are served first come,
+// first served on a busy timeline of the slave, in simulated time: an
+// access takes the earliest gap of one cycle at or after its arrival
+// and holds the slave until it completes.  The policy and the weights
+// have no effect then (a warning says so), nor is there a queue.
+//
+// Checkpoints save the router granted last with its remaining grants
+// and the queue depth counters; policy and weights come from the
+// options, requests in flight are issued again.
+struct arbiter
+: public sc_core::sc_module
+, protected checkpointable
+{
+    typedef arbiter            this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+
+    enum policy
+    {
+        round_robin,
+        fixed_priority,
+        weighted
+    };
+
+    tlm_utils::simple_initiator_socket<this_type>         init_socket;
+    tlm_utils::multi_passthrough_target_socket<this_type> target_socket;
+
+    arbiter( sc_core::sc_module_name,
+             double cycle, sc_core::sc_time_unit unit,
+             policy p = round_robin );
+
+    void   set_policy( policy p ) { arbitration = p; }
+    policy get_policy() const     { return arbitration; }
+
+    // consecutive grants of 'port' under the weighted policy (>= 1)
+    void     set_weight( unsigned port, unsigned weight );
+    unsigned get_weight( unsigned port ) const;
+
+private:
+    // Loosely-Timed (Blocking Transport)
+    virtual void b_transport( int id, tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    // Direct Memory Interface (not arbitrated)
+    virtual bool get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                                     tlm::tlm_dmi& dmi );
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    // Debug transport (not arbitrated, in zero time)
+    virtual unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
+    virtual void end_of_elaboration();
+    virtual void end_of_simulation();
+
+    // checkpointable methods
+    virtual bool save_state( state_type& state, const std::string& prefix );
+    virtual bool restore_state( const state_type& state );
+
+    // blocks until router 'id' holds the grant
+    void acquire( unsigned id );
+    void release();
+
+    // grants the slave to the next pending router (method process)
+    void arbitrate();
+    int  select();
+
+    // temporally decoupled access, arbitrated on 'schedule'
+    void transport_decoupled( int id, tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    // contention statistics, per router
+    struct port_stats
+    {
+        port_stats() : requests(), waits(), blocked() {}
+
+        unsigned long    requests;
+        unsigned long    waits;   // not granted within one cycle
+        sc_core::sc_time blocked; // time waited beyond that cycle
+    };
+
+    // time needed to grant access to the slave
+    sc_core::sc_time cycle;
+    policy           arbitration;
+
+    std::vector<unsigned> weights;
+    std::vector<bool>     pending;
+    unsigned              queued;
+
+    int       owner;   // router holding the grant, -1 if none
+    unsigned  last;    // router granted last
+    unsigned  credits; // remaining consecutive grants of 'last'
+
+    sc_core::sc_event arbitrate_event;
+    sc_core::sc_event granted;
+
+    // with a global quantum: the slave's busy intervals
+    bool     decoupled;
+    timeline schedule;
+
+    std::vector<port_stats> stats;
+    unsigned long           grants;
+    unsigned long           queue_sum;  // queue depth, summed per grant
+    unsigned                queue_max;
+
+    // traffic per router and to the slave, see stats.h
+    std::vector<socket_stats> target_stats;
+    socket_stats              init_stats;
+};
 
 #endif // ARBITER_H_INCLUDED_
 
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,146 @@
+
+#include "banked_ram.h"
+#include "settings.h"
+
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+bank_config::bank_config()
+: banks( 4 )
+, interleave( low )
+, granule( 1 )
+, latency( 10 )
+, occupancy( 10 )
+{}
+
+bool bank_config::parse( const char* spec )
+{
+    return parse_settings( spec, "Banked RAM",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool bank_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "interleave" ) {
+        if( value == "low" )      interleave = low;
+        else if( value == "xor" ) interleave = xor_hash;
+        else return false;
+        return true;
+    } else if( key == "banks" ) {
+        ok = ( in >> banks ) && banks > 0;
+    } else if( key == "granule" ) {
+        ok = ( in >> granule ) && granule > 0;
+    } else if( key == "latency" ) {
+        ok = ( in >> latency ) && latency >= 0;
+    } else if( key == "occupancy" ) {
+        ok = ( in >> occupancy ) && occupancy >= 0;
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+banked_ram::banked_ram( sc_core::sc_module_name name, unsigned size,
+                        const bank_config& config, ram_storage* storage )
+: base_type( name, size, sc_core::sc_time( config.latency, sc_core::SC_NS ),
+             storage )
+, config( config )
+, occupancy( config.occupancy, sc_core::SC_NS )
+, banks( config.banks )
+, touched( config.banks )
+, hash_bits()
+{
+    dmi_enabled = false;
+
+    while( ( 1U << hash_bits ) < config.banks )
+        ++hash_bits;
+    if( config.interleave == bank_config::xor_hash
+        && ( 1U << hash_bits ) != config.banks )
+        SC_REPORT_ERROR( "Banked RAM/Config",
+                         "xor interleaving needs a power of two banks" );
+}
+
+unsigned banked_ram::bank_of( unsigned addr ) const
+{
+    unsigned unit = addr / config.granule;
+    if( config.interleave == bank_config::low || !hash_bits )
+        return unit % config.banks;
+
+    // fold all bits of the granule number onto the bank bits
+    unsigned hash = 0;
+    for( ; unit; unit >>= hash_bits )
+        hash ^= unit & ( config.banks - 1 );
+    return hash;
+}
+
+sc_core::sc_time banked_ram::access_time( unsigned addr, unsigned words,
+                                          bool /* write unused */,
+                                          const sc_core::sc_time& delay )
+{
+    sc_core::sc_time arrival = sc_core::sc_time_stamp() + delay;
+    sc_core::sc_time done    = arrival;
+
+    touched.assign( config.banks, 0 );
+    for( unsigned i = 0; i < words; ++i )
+        ++touched[ bank_of( addr + i ) ];
+
+    for( unsigned i = 0; i < config.banks; ++i ) {
+        if( !touched[i] )
+            continue;
+
+        bank&            b      = banks[i];
+        sc_core::sc_time length = occupancy * touched[i];
+        sc_core::sc_time start  = b.schedule.reserve( arrival, length );
+
+        ++b.accesses;
+        b.words += touched[i];
+        if( start > arrival ) {
+            ++b.conflicts;
+            b.waited += start - arrival;
+        }
+
+        // words of one bank back to back
+        sc_core::sc_time finish = start + occupancy * ( touched[i] - 1 ) + latency;
+        if( finish > done )
+            done = finish;
+    }
+    return done - arrival;
+}
+
+void banked_ram::end_of_simulation()
+{
+    base_type::end_of_simulation();
+
+    sc_core::sc_time elapsed  = sc_core::sc_time_stamp();
+    sc_core::sc_time used     = sc_core::SC_ZERO_TIME;
+    unsigned long    accesses = 0, conflicts = 0;
+
+    for( unsigned i = 0; i < banks.size(); ++i ) {
+        const bank& b = banks[i];
+        accesses  += b.accesses;
+        conflicts += b.conflicts;
+        used      += b.schedule.busy();
+
+        std::cout << name() << " bank " << i << ": "
+                  << b.accesses << " accesses, " << b.words << " words, "
+                  << b.conflicts << " conflicts (waited " << b.waited << ")";
+        if( elapsed != sc_core::SC_ZERO_TIME )
+            std::cout << ", busy " << 100. * ( b.schedule.busy() / elapsed ) << "%";
+        std::cout << std::endl;
+    }
+
+    std::cout << name() << ": " << conflicts << " of " << accesses
+              << " bank accesses conflicting";
+    // the average number of busy banks, at most the number of banks
+    if( elapsed != sc_core::SC_ZERO_TIME )
+        std::cout << ", bank parallelism " << used / elapsed;
+    std::cout << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,93 @@
+#ifndef BANKED_RAM_H_INCLUDED_
+#define BANKED_RAM_H_INCLUDED_
+
+#include "ram.h"
+#include "timeline.h"
+
+#include <string>
+#include <vector>
+
+// Configuration of a banked_ram, from a list of 'key=value' settings
+// (see settings.h):
+//
+//   banks=<n>       number of banks (default: 4)
+//   interleave=<p>  low (consecutive granules in consecutive banks) or
+//                   xor (granule number folded by XOR, needs a power
+//                   of two banks) (default: low)
+//   granule=<n>     words per interleaving unit (default: 1)
+//   latency=<ns>    access time of a word (default: 10)
+//   occupancy=<ns>  time a bank is busy per word (default: 10)
+struct bank_config
+{
+    enum interleave_type { low, xor_hash };
+
+    bank_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned        banks;
+    interleave_type interleave;
+    unsigned        granule;
+    double          latency;
+    double          occupancy;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// Memory target made of independent banks
+//
+// Contents and addressing are those of a ram.  Each word of an access
+// occupies its bank for 'occupancy', starting at the first idle gap
+// of the bank's busy timeline after the access arrives; the words of
+// one bank are served back to back, the banks in parallel.  An access
+// completes 'latency' after the start of its last word.
+//
+// A bank still busy with other accesses when one arrives counts as a
+// conflict, along with the time the access waits for it.  The
+// timelines are kept in simulated time, so accesses of temporally
+// decoupled initiators, which arrive out of order, find the gaps left
+// between earlier reservations.
+//
+// DMI is denied, as direct accesses would bypass the banks.
+struct banked_ram
+  : public ram
+{
+    typedef banked_ram this_type;
+    typedef ram        base_type;
+
+    // takes ownership of 'storage', which has to hold 'size' words
+    banked_ram( sc_core::sc_module_name, unsigned size,
+                const bank_config& config, ram_storage* storage = NULL );
+
+private:
+    struct bank
+    {
+        bank() : schedule(), accesses(), words(), conflicts(), waited() {}
+
+        timeline           schedule;
+        unsigned long      accesses;
+        unsigned long long words;
+        unsigned long      conflicts;
+        sc_core::sc_time   waited; // for conflicting accesses
+    };
+
+    virtual sc_core::sc_time access_time( unsigned addr, unsigned words,
+                                          bool write,
+                                          const sc_core::sc_time& delay );
+
+    virtual void end_of_simulation();
+
+    unsigned bank_of( unsigned addr ) const;
+
+    bank_config           config;
+    sc_core::sc_time      occupancy;
+    std::vector<bank>     banks;
+    std::vector<unsigned> touched;   // words per bank of one access
+    unsigned              hash_bits; // log2 of the banks, for xor
+};
+
+#endif // BANKED_RAM_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
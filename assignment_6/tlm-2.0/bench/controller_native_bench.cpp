@@ -0,0 +1,29 @@
+/*
+ * Native baseline of the controller firmware
+ *
+ * Runs the workload of ../firmware (car_controller_set_control_data on
+ * pseudo-random sensor readings) on the host.  Its checksum matches the
+ * exit code of the firmware on rv32_iss, whose instructions per
+ * iteration and MIPS set the calls per second here into relation.
+ */
+#include "workload.h"
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cstdlib>  // std::strtoul
+#include <iostream> // std::cout, std::endl
+
+int main( int argc, char* argv[] )
+{
+    unsigned iterations = argc > 1 ? std::strtoul( argv[1], NULL, 0 ) : 1000000;
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    unsigned checksum = controller_workload( iterations );
+    double wall = std::chrono::duration<double>( clock::now() - start ).count();
+
+    std::cout << "controller: " << iterations << " iterations, checksum "
+              << checksum << " (exit code " << ( checksum & 0xff ) << "), "
+              << wall << " s, " << wall / iterations * 1e9
+              << " ns per iteration" << std::endl;
+    return 0;
+}
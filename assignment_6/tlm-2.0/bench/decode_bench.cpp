@@ -0,0 +1,124 @@
+/*
+ * Microbenchmark for address_map::decode
+ *
+ * Builds maps with 2 to 10000 contiguous regions (listed in shuffled
+ * order, so the index has to sort them) and compares the indexed
+ * decode against a plain linear scan over all regions.
+ */
+#include "address_map.h"
+
+#include <algorithm>     // std::shuffle
+#include <chrono>        // std::chrono::steady_clock
+#include <cstdlib>       // std::rand, EXIT_FAILURE
+#include <iomanip>       // std::setw
+#include <iostream>      // std::cout, std::endl
+#include <random>        // std::mt19937
+#include <sstream>       // std::stringstream
+#include <vector>
+
+namespace {
+
+const address_map::address_type region_size = 0x10;
+const unsigned decodes = 1000000;
+
+struct region {
+    address_map::address_type start;
+    address_map::address_type end;
+};
+
+// reference implementation: what decode did before the index
+address_map::index_type
+linear_decode( const std::vector<region>& regions,
+               address_map::address_type addr )
+{
+    for( address_map::index_type i = 0; i < regions.size(); ++i )
+        if( regions[i].start <= addr && addr <= regions[i].end )
+            return i;
+    return address_map::npos;
+}
+
+template< typename Decode >
+double ns_per_decode( Decode decode,
+                      const std::vector<address_map::address_type>& addrs,
+                      address_map::index_type& checksum )
+{
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point start = clock::now();
+    for( unsigned i = 0; i < addrs.size(); ++i )
+        checksum += decode( addrs[i] );
+    clock::time_point stop = clock::now();
+
+    return std::chrono::duration<double, std::nano>( stop - start ).count()
+           / addrs.size();
+}
+
+} // anonymous namespace
+
+int main()
+{
+    const address_map::index_type sizes[] = { 2, 10, 100, 1000, 10000 };
+
+    std::cout << std::setw(8)  << "regions"
+              << std::setw(14) << "linear [ns]"
+              << std::setw(14) << "indexed [ns]"
+              << std::setw(10) << "speedup"
+              << std::endl;
+
+    for( unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s ) {
+        const address_map::index_type n = sizes[s];
+
+        std::vector<region> regions( n );
+        std::vector<address_map::index_type> order( n );
+        for( address_map::index_type i = 0; i < n; ++i ) {
+            regions[i].start = i * region_size;
+            regions[i].end   = regions[i].start + region_size - 1;
+            order[i] = i;
+        }
+        std::shuffle( order.begin(), order.end(), std::mt19937( n ) );
+
+        std::stringstream mem_map;
+        for( address_map::index_type i = 0; i < n; ++i )
+            mem_map << std::dec << order[i] << std::hex
+                    << " 0x" << regions[order[i]].start
+                    << " 0x" << regions[order[i]].end << "\n";
+
+        // silence the per-slave report of the loader
+        std::streambuf* out = std::cout.rdbuf( NULL );
+        address_map map( n, mem_map );
+        std::cout.rdbuf( out );
+        std::cout.clear();
+
+        // uniformly distributed hits plus a few unmapped addresses
+        std::vector<address_map::address_type> addrs( decodes );
+        for( unsigned i = 0; i < decodes; ++i )
+            addrs[i] = std::rand() % ( ( n + 1 ) * region_size );
+
+        for( unsigned i = 0; i < decodes; ++i ) {
+            if( map.decode( addrs[i] ) != linear_decode( regions, addrs[i] ) ) {
+                std::cerr << "decode mismatch at 0x" << std::hex << addrs[i]
+                          << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        address_map::index_type checksum = 0;
+        double linear  = ns_per_decode(
+            [&]( address_map::address_type a ) { return linear_decode( regions, a ); },
+            addrs, checksum );
+        double indexed = ns_per_decode(
+            [&]( address_map::address_type a ) { return map.decode( a ); },
+            addrs, checksum );
+
+        std::cout << std::dec << std::fixed << std::setprecision(2)
+                  << std::setw(8)  << n
+                  << std::setw(14) << linear
+                  << std::setw(14) << indexed
+                  << std::setw(10) << linear / indexed
+                  << ( checksum ? "" : " " ) // keep the loops alive
+                  << std::endl;
+    }
+    return 0;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
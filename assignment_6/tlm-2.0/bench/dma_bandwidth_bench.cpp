@@ -0,0 +1,215 @@
+/*
+ * Bandwidth benchmark of the DMA controller
+ *
+ * A CPU and the DMA controller share two rams over a crossbar, the
+ * DMA registers are the crossbar's third slave.  The CPU writes a
+ * block and a chain of descriptors into ram0 (in zero time), starts
+ * the DMA, waits for its interrupt and checks the copy in ram1.
+ * Reported are the simulated bandwidth of the copy and the
+ * simulation speed.
+ *
+ *   dma_bandwidth_bench [dma settings] [words] [descriptors]
+ *
+ * The settings are those of dma_config (see dma.h), e.g.
+ * "burst=16,depth=4,dmi=0".
+ */
+#include <systemc>
+#include <tlm.h>
+#include <tlm_utils/simple_initiator_socket.h>
+
+#include "crossbar.h"
+#include "dma.h"
+#include "ram.h"
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cstdlib>  // std::atoi, EXIT_FAILURE
+#include <fstream>  // std::ofstream
+#include <iostream> // std::cout, std::cerr, std::endl
+#include <vector>
+
+namespace {
+
+const unsigned    ram_size  = 0x10000;
+const unsigned    dma_base  = 2 * ram_size;
+const char* const map_file  = "dma_mem_map.txt";
+
+void write_mem_map()
+{
+    std::ofstream out( map_file );
+    out << std::hex
+        << "0 0x0 0x" << ram_size - 1 << "\n"
+        << "1 0x" << ram_size << " 0x" << 2 * ram_size - 1 << "\n"
+        << "2 0x" << dma_base << " 0x" << dma_base + dma::registers - 1
+        << "\n";
+}
+
+// programs the DMA to copy 'words' from ram0 to ram1 in 'segments'
+// descriptors, placed at the end of ram0
+struct cpu
+: public sc_core::sc_module
+{
+    typedef cpu                this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::simple_initiator_socket<this_type> init_socket;
+    sc_core::sc_in<bool>                          irq;
+
+    SC_HAS_PROCESS(this_type);
+    cpu( sc_core::sc_module_name, unsigned words, unsigned segments )
+    : base_type()
+    , init_socket( "init_socket" )
+    , irq( "irq" )
+    , words( words )
+    , segments( segments )
+    , ok()
+    , copied()
+    , elapsed()
+    {
+        SC_THREAD( run );
+    }
+
+    void run()
+    {
+        std::vector<unsigned> block( words );
+        for( unsigned i = 0; i < words; ++i )
+            block[i] = i * 2654435761u;
+        debug( tlm::TLM_WRITE_COMMAND, 0, block );
+
+        // descriptors of about equal segments
+        unsigned              table = ram_size - 4 * segments;
+        std::vector<unsigned> chain;
+        for( unsigned s = 0; s < segments; ++s ) {
+            unsigned first = unsigned( sc_dt::uint64( words ) * s / segments );
+            unsigned last  = unsigned( sc_dt::uint64( words ) * ( s + 1 ) / segments );
+            chain.push_back( first );
+            chain.push_back( ram_size + first );
+            chain.push_back( last - first );
+            chain.push_back( s + 1 < segments ? table + 4 * ( s + 1 )
+                                              : dma::end_of_chain );
+        }
+        debug( tlm::TLM_WRITE_COMMAND, table, chain );
+
+        sc_core::sc_time start = sc_core::sc_time_stamp();
+        write( dma_base + dma::reg_desc, table );
+        write( dma_base + dma::reg_ctrl, dma::ctrl_start | dma::ctrl_irq );
+        wait( irq.posedge_event() );
+        elapsed = sc_core::sc_time_stamp() - start;
+
+        copied = read( dma_base + dma::reg_words );
+        write( dma_base + dma::reg_status, dma::status_done );
+
+        std::vector<unsigned> copy( words );
+        debug( tlm::TLM_READ_COMMAND, ram_size, copy );
+        ok = copy == block;
+
+        sc_core::sc_stop();
+    }
+
+    unsigned         words;
+    unsigned         segments;
+    bool             ok;
+    unsigned         copied;
+    sc_core::sc_time elapsed;
+
+private:
+    void access( tlm::tlm_command command, unsigned addr, unsigned& data )
+    {
+        tlm::tlm_generic_payload trans;
+        sc_core::sc_time         delay = sc_core::SC_ZERO_TIME;
+        trans.set_command( command );
+        trans.set_address( addr );
+        trans.set_data_ptr( reinterpret_cast< unsigned char* >( &data ) );
+        trans.set_data_length( sizeof(unsigned) );
+        trans.set_streaming_width( sizeof(unsigned) );
+        trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+        init_socket->b_transport( trans, delay );
+        if( trans.is_response_error() )
+            SC_REPORT_ERROR( "CPU/Access", trans.get_response_string().c_str() );
+        wait( delay );
+    }
+
+    void write( unsigned addr, unsigned value )
+    { access( tlm::TLM_WRITE_COMMAND, addr, value ); }
+
+    unsigned read( unsigned addr )
+    {
+        unsigned value = 0;
+        access( tlm::TLM_READ_COMMAND, addr, value );
+        return value;
+    }
+
+    void debug( tlm::tlm_command command, unsigned addr,
+                std::vector<unsigned>& data )
+    {
+        tlm::tlm_generic_payload trans;
+        unsigned length = data.size() * sizeof(unsigned);
+        trans.set_command( command );
+        trans.set_address( addr );
+        trans.set_data_ptr( reinterpret_cast< unsigned char* >( &data[0] ) );
+        trans.set_data_length( length );
+        trans.set_streaming_width( length );
+
+        if( init_socket->transport_dbg( trans ) != length )
+            SC_REPORT_ERROR( "CPU/Debug", "incomplete debug transport" );
+    }
+};
+
+} // anonymous namespace
+
+int sc_main( int argc, char* argv[] )
+{
+    if( argc > 4 ) {
+        std::cerr << "usage: " << argv[0]
+                  << " [dma settings] [words] [descriptors]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    dma_config config;
+    if( argc > 1 && !config.parse( argv[1] ) )
+        return EXIT_FAILURE;
+    unsigned words    = argc > 2 ? std::atoi( argv[2] ) : 0x8000;
+    unsigned segments = argc > 3 ? std::atoi( argv[3] ) : 8;
+
+    if( !words || !segments || segments > words
+        || words + 4 * segments > ram_size ) {
+        std::cerr << argv[0] << ": need 0 < descriptors <= words, and both"
+                  << " with the descriptors in " << ram_size << " words"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    write_mem_map();
+    cpu           c( "cpu", words, segments );
+    dma           d( "dma", config );
+    crossbar<2,3> x( "crossbar", map_file );
+    ram           r0( "ram0", ram_size, sc_core::sc_time( 10, sc_core::SC_NS ) );
+    ram           r1( "ram1", ram_size, sc_core::sc_time( 10, sc_core::SC_NS ) );
+    sc_core::sc_signal<bool> irq( "irq" );
+
+    c.init_socket.bind( x.target_sockets[0] );
+    d.init_socket.bind( x.target_sockets[1] );
+    x.init_sockets[0].bind( r0.target_socket );
+    x.init_sockets[1].bind( r1.target_socket );
+    x.init_sockets[2].bind( d.target_socket );
+    d.irq.bind( irq );
+    c.irq.bind( irq );
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    sc_core::sc_start();
+    double wall = std::chrono::duration<double>( clock::now() - start ).count();
+
+    double bytes = double( c.copied ) * sizeof(unsigned);
+    double sim   = c.elapsed.to_seconds();
+    std::cout << "burst " << config.burst << ", depth " << config.depth
+              << ( config.dmi ? ", dmi" : "" ) << ": " << c.copied
+              << " words in " << c.elapsed << " ("
+              << ( sim > 0 ? bytes / sim / 1e6 : 0 ) << " MB/s simulated), "
+              << wall << " s wall clock"
+              << ( c.ok ? "" : ", COPY MISMATCH" ) << std::endl;
+
+    return c.ok ? 0 : EXIT_FAILURE;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
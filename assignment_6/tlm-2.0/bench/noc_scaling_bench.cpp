@@ -0,0 +1,162 @@
+/*
+ * Scaling benchmark for the interconnects
+ *
+ * Connects N traffic generators to N rams, either through a crossbar
+ * or through a mesh of about sqrt(N) x sqrt(N) nodes, and reports the
+ * simulated throughput and the simulation speed.  Every generator
+ * issues random accesses over all rams, so most of the traffic
+ * crosses the interconnect.
+ *
+ *   noc_scaling_bench <mesh|crossbar> <cores> [transactions]
+ *
+ * The crossbar is a template, it is only built for 4, 16 and 64
+ * cores; the mesh takes any number.
+ */
+#include <systemc>
+#include <tlm.h>
+
+#include "crossbar.h"
+#include "mesh.h"
+#include "ram.h"
+#include "traffic_generator.h"
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cmath>    // std::sqrt
+#include <cstdlib>  // std::atoi, EXIT_FAILURE
+#include <cstring>  // std::strcmp
+#include <fstream>  // std::ofstream
+#include <iostream> // std::cout, std::cerr, std::endl
+#include <sstream>  // std::stringstream
+#include <vector>
+
+namespace {
+
+const unsigned    region_size = 0x1000;
+const char* const map_file    = "noc_mem_map.txt";
+
+// one region per ram, consecutive
+void write_mem_map( unsigned rams )
+{
+    std::ofstream out( map_file );
+    for( unsigned i = 0; i < rams; ++i )
+        out << i << std::hex << " 0x" << i * region_size
+            << " 0x" << ( i + 1 ) * region_size - 1 << std::dec << "\n";
+}
+
+// generators and rams, bound to the interconnect by the caller
+struct platform
+{
+    platform( unsigned cores, unsigned transactions )
+    {
+        for( unsigned i = 0; i < cores; ++i ) {
+            std::stringstream spec;
+            spec << "pattern=random,count=" << transactions
+                 << ",seed=" << i + 1;
+
+            traffic_config config;
+            if( !config.parse( spec.str().c_str() ) )
+                std::exit( EXIT_FAILURE );
+
+            std::stringstream gen, mem;
+            gen << "generator_" << i;
+            mem << "ram_" << i;
+            generators.push_back( new traffic_generator(
+                gen.str().c_str(), 0, cores * region_size - 1, config ) );
+            rams.push_back( new ram( mem.str().c_str(), region_size,
+                                     sc_core::sc_time( 10, sc_core::SC_NS ) ) );
+        }
+    }
+
+    std::vector<traffic_generator*> generators;
+    std::vector<ram*>               rams;
+};
+
+template< unsigned Cores >
+void build_crossbar( platform& p )
+{
+    crossbar< Cores, Cores >* c
+        = new crossbar< Cores, Cores >( "crossbar", map_file );
+    for( unsigned i = 0; i < Cores; ++i ) {
+        p.generators[i]->init_socket.bind( c->target_sockets[i] );
+        c->init_sockets[i].bind( p.rams[i]->target_socket );
+    }
+}
+
+void build_mesh( platform& p )
+{
+    unsigned cores = p.generators.size();
+
+    mesh_config config;
+    config.width  = unsigned( std::sqrt( double( cores ) ) );
+    config.height = ( cores + config.width - 1 ) / config.width;
+
+    // a core and its ram share a node
+    mesh* m = new mesh( "mesh", config, map_file );
+    for( unsigned i = 0; i < cores; ++i ) {
+        p.generators[i]->init_socket.bind( m->target_socket );
+        m->init_socket.bind( p.rams[i]->target_socket );
+        m->place_initiator( i, i );
+        m->place_target( i, i );
+    }
+}
+
+} // anonymous namespace
+
+int sc_main( int argc, char* argv[] )
+{
+    if( argc < 3 || argc > 4 ) {
+        std::cerr << "usage: " << argv[0]
+                  << " <mesh|crossbar> <cores> [transactions]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool     use_mesh     = !std::strcmp( argv[1], "mesh" );
+    unsigned cores        = std::atoi( argv[2] );
+    unsigned transactions = argc > 3 ? std::atoi( argv[3] ) : 1000;
+
+    if( !use_mesh && std::strcmp( argv[1], "crossbar" ) ) {
+        std::cerr << argv[0] << ": unknown interconnect '" << argv[1]
+                  << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if( !cores || !transactions ) {
+        std::cerr << argv[0] << ": cores and transactions must be positive"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    write_mem_map( cores );
+    platform p( cores, transactions );
+
+    if( use_mesh ) {
+        build_mesh( p );
+    } else {
+        switch( cores ) {
+            case 4:  build_crossbar< 4 >( p );  break;
+            case 16: build_crossbar< 16 >( p ); break;
+            case 64: build_crossbar< 64 >( p ); break;
+            default:
+                std::cerr << argv[0] << ": the crossbar is built for 4, 16"
+                          << " and 64 cores only" << std::endl;
+                return EXIT_FAILURE;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    sc_core::sc_start();
+    double wall = std::chrono::duration<double>( clock::now() - start ).count();
+
+    double total     = double( cores ) * transactions;
+    double simulated = sc_core::sc_time_stamp().to_seconds() * 1e6;
+
+    std::cout << argv[1] << " " << cores << " cores: " << total
+              << " transactions in " << sc_core::sc_time_stamp()
+              << " (" << ( simulated > 0 ? total / simulated : 0 )
+              << " per us simulated), " << wall << " s wall clock ("
+              << ( wall > 0 ? total / wall : 0 ) << " per s)" << std::endl;
+
+    return 0;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,138 @@
+/*
+ * Microbenchmark for static_address_map::decode
+ *
+ * Compares the decoding of memory maps compiled into the program
+ * against address_map::decode on the same maps loaded at runtime:
+ * the map generated from ../mem_map.txt (see gen_mem_map.sh) and
+ * maps with 2 to 64 contiguous regions in shuffled slave order.
+ */
+#include "address_map.h"
+#include "static_address_map.h"
+#include "mem_map_gen.h"
+
+#include <array>         // std::array
+#include <chrono>        // std::chrono::steady_clock
+#include <cstdlib>       // std::rand, EXIT_FAILURE
+#include <iomanip>       // std::setw
+#include <iostream>      // std::cout, std::endl
+#include <sstream>       // std::stringstream
+#include <vector>
+
+namespace {
+
+const address_map::address_type region_size = 0x10;
+const unsigned decodes = 1000000;
+
+// N contiguous regions, slave i at position (5 * i) % N, which is a
+// permutation for every power of two
+template< address_map::index_type N >
+constexpr std::array< static_region, N > shuffled_regions()
+{
+    std::array< static_region, N > regions {};
+    for( address_map::index_type i = 0; i < N; ++i ) {
+        regions[i].start = ( 5 * i ) % N * region_size;
+        regions[i].end   = regions[i].start + region_size - 1;
+    }
+    return regions;
+}
+
+template< address_map::index_type N >
+struct shuffled_map {
+    static constexpr std::array< static_region, N > regions
+        = shuffled_regions<N>();
+};
+
+template< typename Decode >
+double ns_per_decode( Decode decode,
+                      const std::vector<address_map::address_type>& addrs,
+                      address_map::index_type& checksum )
+{
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point start = clock::now();
+    for( unsigned i = 0; i < addrs.size(); ++i )
+        checksum += decode( addrs[i] );
+    clock::time_point stop = clock::now();
+
+    return std::chrono::duration<double, std::nano>( stop - start ).count()
+           / addrs.size();
+}
+
+template< typename Map >
+bool run( const char* label )
+{
+    typedef static_address_map< Map > static_map;
+    const address_map::index_type n = static_map::size();
+
+    // the same map, as the runtime loader sees it
+    std::stringstream mem_map;
+    address_map::address_type top = 0;
+    for( address_map::index_type i = 0; i < n; ++i ) {
+        mem_map << std::dec << i << std::hex
+                << " 0x" << static_map::get_start_address( i )
+                << " 0x" << static_map::get_end_address( i ) << "\n";
+        if( static_map::get_end_address( i ) > top )
+            top = static_map::get_end_address( i );
+    }
+
+    // silence the per-slave report of the loader
+    std::streambuf* out = std::cout.rdbuf( NULL );
+    address_map map( n, mem_map );
+    std::cout.rdbuf( out );
+    std::cout.clear();
+
+    // uniformly distributed hits plus a few unmapped addresses
+    std::vector<address_map::address_type> addrs( decodes );
+    for( unsigned i = 0; i < decodes; ++i )
+        addrs[i] = std::rand() % ( top + 1 + region_size );
+
+    for( unsigned i = 0; i < decodes; ++i ) {
+        if( map.decode( addrs[i] ) != static_map::decode( addrs[i] ) ) {
+            std::cerr << label << ": decode mismatch at 0x" << std::hex
+                      << addrs[i] << std::endl;
+            return false;
+        }
+    }
+
+    address_map::index_type checksum = 0;
+    double runtime = ns_per_decode(
+        [&]( address_map::address_type a ) { return map.decode( a ); },
+        addrs, checksum );
+    double compiled = ns_per_decode(
+        []( address_map::address_type a ) { return static_map::decode( a ); },
+        addrs, checksum );
+
+    std::cout << std::dec << std::fixed << std::setprecision(2)
+              << std::setw(12) << label
+              << std::setw(9)  << n
+              << std::setw(14) << runtime
+              << std::setw(14) << compiled
+              << std::setw(10) << runtime / compiled
+              << ( checksum ? "" : " " ) // keep the loops alive
+              << std::endl;
+    return true;
+}
+
+} // anonymous namespace
+
+int main()
+{
+    std::cout << std::setw(12) << "map"
+              << std::setw(9)  << "regions"
+              << std::setw(14) << "runtime [ns]"
+              << std::setw(14) << "static [ns]"
+              << std::setw(10) << "speedup"
+              << std::endl;
+
+    bool ok = run< generated_mem_map >( "mem_map.txt" )
+           && run< shuffled_map<2> >( "shuffled" )
+           && run< shuffled_map<4> >( "shuffled" )
+           && run< shuffled_map<8> >( "shuffled" )
+           && run< shuffled_map<16> >( "shuffled" )
+           && run< shuffled_map<32> >( "shuffled" )
+           && run< shuffled_map<64> >( "shuffled" );
+
+    return ok ? 0 : EXIT_FAILURE;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
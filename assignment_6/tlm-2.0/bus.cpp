@@ -3,33 +3,122 @@
 #include <tlm.h>
 
 #include "bus.h"
+#include "debug_transport.h"
+#include "tracer.h"
 
+#include <iostream> // std::cout, std::endl
 
-bus::bus( sc_core::sc_module_name /* unused */ )
+
+bus::bus( sc_core::sc_module_name /* unused */, const char* mem_map )
 : base_type()
 , init_socket("init_socket")
 , target_socket("target_socket")
+, mem_map( mem_map )
 {
     target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
 }
 
 bus::~bus()
 { }
 
-// FILLME: implement bus::b_transport
-//   NOTE: You can use 'targets.decode()' from the address_map class for
-//         the actual decoding.  'address_map::npos' is returned, if the
-//         requested address is not mapped.
+void bus::b_transport( int id, tlm::tlm_generic_payload& trans,
+                       sc_core::sc_time& delay )
+{
+    decode_cache& cache = decoded[id];
+    stats_scope   initiator( target_stats[id], trans, delay );
+    trace_scope   hop( *this, "route", trans, delay );
+
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = cache.decode( targets, addr );
+
+    if( target == address_map::npos ) {
+        trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+        return;
+    }
+    stats_scope slave( init_stats[target], trans, delay );
+
+    // forward with the address local to the target, restore it after
+    trans.set_address( cache.get_local_address( addr ) );
+    init_socket[target]->b_transport( trans, delay );
+    trans.set_address( addr );
+}
+
+bool bus::get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                              tlm::tlm_dmi& dmi )
+{
+    decode_cache& cache = decoded[id];
+
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = cache.decode( targets, addr );
+
+    if( target == address_map::npos )
+        return false;
+
+    trans.set_address( cache.get_local_address( addr ) );
+    bool granted = init_socket[target]->get_direct_mem_ptr( trans, dmi );
+    trans.set_address( addr );
+
+    // the region (or the range DMI is denied for) is reported in the
+    // target's address space, translate it back
+    address_map::address_type start = dmi.get_start_address();
+    address_map::address_type end   = dmi.get_end_address();
+    targets.get_global_range( target, start, end );
+    dmi.set_start_address( start );
+    dmi.set_end_address( end );
 
+    return granted;
+}
+
+void bus::invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                     sc_dt::uint64 end )
+{
+    address_map::address_type global_start = start;
+    address_map::address_type global_end   = end;
+    targets.get_global_range( id, global_start, global_end );
 
+    // we don't know who holds the pointer, tell every initiator
+    for( unsigned i = 0; i < target_socket.size(); ++i )
+        target_socket[i]->invalidate_direct_mem_ptr( global_start, global_end );
+}
+
+unsigned int bus::transport_dbg( int /* id unused */,
+                                tlm::tlm_generic_payload& trans )
+{
+    // the decode caches are left alone
+    return route_dbg( targets, trans,
+        [this]( address_map::index_type target, tlm::tlm_generic_payload& t )
+        { return init_socket[target]->transport_dbg( t ); } );
+}
 
 // stuff for address decoding
 void bus::end_of_elaboration()
 {
     // reset address map with correct data
-    address_map( init_socket.size(), "mem_map.txt" ).swap( targets );
+    address_map( init_socket.size(), mem_map.c_str() ).swap( targets );
 
     sc_assert( init_socket.size() == targets.size() );
+
+    decoded.assign( target_socket.size(), decode_cache() );
+
+    target_stats.resize( target_socket.size() );
+    init_stats.resize( init_socket.size() );
+    for( unsigned i = 0; i < target_stats.size(); ++i )
+        register_stats( *this, "target_socket", target_stats[i], i );
+    for( unsigned i = 0; i < init_stats.size(); ++i )
+        register_stats( *this, "init_socket", init_stats[i], i );
+}
+
+void bus::end_of_simulation()
+{
+    for( unsigned id = 0; id < decoded.size(); ++id ) {
+        std::cout << name() << " decode cache initiator " << id
+                  << ": " << decoded[id].hits << " hits, "
+                  << decoded[id].misses << " misses"
+                  << std::endl;
+    }
 }
 
 /* vim: set ts=4 sw=4 tw=72 et :*/
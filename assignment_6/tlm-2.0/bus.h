@@ -2,6 +2,10 @@
 #define BUS_H_INCLUDED_
 
 #include "address_map.h"
+#include "decode_cache.h"
+#include "stats.h"
+
+#include <string>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 #include <systemc>
@@ -20,7 +24,8 @@ struct bus
     tlm_utils::multi_passthrough_initiator_socket<this_type> init_socket;
     tlm_utils::multi_passthrough_target_socket<this_type>    target_socket;
 
-    bus( sc_core::sc_module_name = sc_core::sc_gen_unique_name("bus") );
+    bus( sc_core::sc_module_name = sc_core::sc_gen_unique_name("bus"),
+         const char* mem_map = "mem_map.txt" );
     ~bus();
 
 private:
@@ -28,10 +33,28 @@ private:
     virtual void b_transport( int id, tlm::tlm_generic_payload& trans,
                               sc_core::sc_time& delay );
 
+    // Direct Memory Interface
+    virtual bool get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                                     tlm::tlm_dmi& dmi );
+    virtual void invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    // Debug transport, in zero time (see debug_transport.h)
+    virtual unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
     // stuff for address decoding
     virtual void end_of_elaboration();
+    virtual void end_of_simulation();
 
+    std::string mem_map;
     address_map targets;
+
+    // last decoded region, one per initiator
+    std::vector<decode_cache> decoded;
+
+    // traffic per initiator and per target, see stats.h
+    std::vector<socket_stats> target_stats;
+    std::vector<socket_stats> init_stats;
 };
 
 #endif // BUS_H_INCLUDED_
@@ -1,6 +1,274 @@
 #include "bus_ca.h"
+#include "debug_transport.h"
 
-// FILLME: implement bus_ca functions
 
+bus_ca::bus_ca( sc_core::sc_module_name /* unused */, const char* mem_map,
+                sc_core::sc_time cycle )
+: base_type()
+, init_socket("init_socket")
+, target_socket("target_socket")
+, mem_map( mem_map )
+, cycle( cycle )
+, request_peq("request_peq")
+, response_peq("response_peq")
+{
+    target_socket.register_nb_transport_fw(this, &this_type::nb_transport_fw);
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_nb_transport_bw(this, &this_type::nb_transport_bw);
+
+    SC_THREAD( request_thread );
+    SC_THREAD( response_thread );
+}
+
+tlm::tlm_sync_enum
+bus_ca::nb_transport_fw( int id, tlm::tlm_generic_payload& trans,
+                         tlm::tlm_phase& phase, sc_core::sc_time& delay )
+{
+    if( phase == tlm::BEGIN_REQ ) {
+        decode_cache& cache = decoded[id];
+
+        address_map::address_type addr = trans.get_address();
+        address_map::index_type slave = cache.decode( targets, addr );
+
+        if( slave == address_map::npos ) {
+            trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+            return tlm::TLM_COMPLETED;
+        }
+
+        route& r = route_of( trans );
+        r.master     = id;
+        r.slave      = slave;
+        r.addr       = addr;
+        r.slave_open = false;
+        r.done       = NULL;
+
+        // the slave sees its local address until the response
+        trans.set_address( cache.get_local_address( addr ) );
+
+        // the master may free the payload as soon as it has the
+        // response, the bus holds it until the slave's END_RESP too
+        if( trans.has_mm() )
+            trans.acquire();
+        request_peq.notify( trans, delay );
+        return tlm::TLM_ACCEPTED;
+    }
+
+    if( phase == tlm::END_RESP ) {
+        response_open[id] = NULL;
+        complete( trans );
+        if( trans.has_mm() )
+            trans.release();
+        response_free.notify( delay );
+        return tlm::TLM_COMPLETED;
+    }
+
+    SC_REPORT_ERROR( "bus_ca/Protocol", "unexpected phase from master" );
+    return tlm::TLM_COMPLETED;
+}
+
+tlm::tlm_sync_enum
+bus_ca::nb_transport_bw( int id, tlm::tlm_generic_payload& trans,
+                         tlm::tlm_phase& phase, sc_core::sc_time& delay )
+{
+    if( phase != tlm::END_REQ && phase != tlm::BEGIN_RESP ) {
+        SC_REPORT_ERROR( "bus_ca/Protocol", "unexpected phase from slave" );
+        return tlm::TLM_COMPLETED;
+    }
+
+    // BEGIN_RESP implies END_REQ
+    if( request_open[id] == &trans ) {
+        request_open[id]  = NULL;
+        request_ready[id] = sc_core::sc_time_stamp() + delay;
+        request_free.notify( delay );
+    }
+
+    if( phase == tlm::BEGIN_RESP )
+        response_peq.notify( trans, delay );
+
+    return tlm::TLM_ACCEPTED;
+}
+
+void bus_ca::b_transport( int id, tlm::tlm_generic_payload& trans,
+                          sc_core::sc_time& delay )
+{
+    sc_core::sc_event done;
+
+    // the phases are timed by the kernel
+    wait( delay );
+    delay = sc_core::SC_ZERO_TIME;
+
+    tlm::tlm_phase   phase = tlm::BEGIN_REQ;
+    sc_core::sc_time zero  = sc_core::SC_ZERO_TIME;
+    if( nb_transport_fw( id, trans, phase, zero ) == tlm::TLM_COMPLETED )
+        return;
+
+    // no phases towards the master, just wake us up at the end
+    route_of( trans ).done = &done;
+    wait( done );
+}
+
+unsigned int bus_ca::transport_dbg( int /* id unused */,
+                                   tlm::tlm_generic_payload& trans )
+{
+    // outside the request and response queues
+    return route_dbg( targets, trans,
+        [this]( address_map::index_type slave, tlm::tlm_generic_payload& t )
+        { return init_socket[slave]->transport_dbg( t ); } );
+}
+
+void bus_ca::request_thread()
+{
+    while( true ) {
+        wait( request_peq.get_event() | request_free );
+
+        tlm::tlm_generic_payload* trans;
+        while( ( trans = request_peq.get_next_transaction() ) ) {
+            const route& r = route_of( *trans );
+            request_queue[r.slave].push_back( trans );
+
+            // accept right away, the master may issue its next request
+            if( !r.done ) {
+                tlm::tlm_phase   phase = tlm::END_REQ;
+                sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+                target_socket[r.master]->nb_transport_bw( *trans, phase, delay );
+            }
+        }
+
+        const sc_core::sc_time now = sc_core::sc_time_stamp();
+        sc_core::sc_time next = now;
+        for( unsigned s = 0; s < request_queue.size(); ++s ) {
+            while( !request_open[s] && !request_queue[s].empty()
+                   && request_ready[s] <= now )
+                send_request( s );
+
+            // a slave becoming free later: make sure we wake up again
+            if( !request_open[s] && !request_queue[s].empty()
+                && ( next == now || request_ready[s] < next ) )
+                next = request_ready[s];
+        }
+        if( next != now )
+            request_free.notify( next - now );
+    }
+}
+
+void bus_ca::send_request( unsigned slave )
+{
+    tlm::tlm_generic_payload* trans = request_queue[slave].front();
+    request_queue[slave].pop_front();
+
+    route& r = route_of( *trans );
+    r.slave_open = true;
+
+    tlm::tlm_phase   phase = tlm::BEGIN_REQ;
+    sc_core::sc_time delay = cycle;
+
+    switch( init_socket[slave]->nb_transport_fw( *trans, phase, delay ) ) {
+        case tlm::TLM_ACCEPTED:
+            // wait for END_REQ or BEGIN_RESP on the backward path
+            request_open[slave] = trans;
+            return;
+        case tlm::TLM_COMPLETED:
+            r.slave_open = false;
+            response_peq.notify( *trans, delay );
+            break;
+        case tlm::TLM_UPDATED:
+            if( phase == tlm::BEGIN_RESP )
+                response_peq.notify( *trans, delay );
+            break;
+    }
+    request_ready[slave] = sc_core::sc_time_stamp() + delay;
+}
+
+void bus_ca::response_thread()
+{
+    while( true ) {
+        wait( response_peq.get_event() | response_free );
+
+        tlm::tlm_generic_payload* trans;
+        while( ( trans = response_peq.get_next_transaction() ) ) {
+            route& r = route_of( *trans );
+            trans->set_address( r.addr );
+
+            // everything has to go through the bus to be timed
+            trans->set_dmi_allowed( false );
+
+            if( r.done ) {
+                sc_core::sc_event* done = r.done;
+                complete( *trans );
+                if( trans->has_mm() )
+                    trans->release();
+                done->notify();
+            } else {
+                response_queue[r.master].push_back( trans );
+            }
+        }
+
+        for( unsigned m = 0; m < response_queue.size(); ++m )
+            while( !response_open[m] && !response_queue[m].empty() )
+                send_response( m );
+    }
+}
+
+void bus_ca::send_response( unsigned master )
+{
+    tlm::tlm_generic_payload* trans = response_queue[master].front();
+    response_queue[master].pop_front();
+
+    tlm::tlm_phase   phase = tlm::BEGIN_RESP;
+    sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+
+    if( target_socket[master]->nb_transport_bw( *trans, phase, delay )
+        == tlm::TLM_ACCEPTED ) {
+        // wait for END_RESP on the forward path
+        response_open[master] = trans;
+        return;
+    }
+    complete( *trans );
+    if( trans->has_mm() )
+        trans->release();
+}
+
+// final phase towards the slave
+void bus_ca::complete( tlm::tlm_generic_payload& trans )
+{
+    route& r = route_of( trans );
+
+    if( r.slave_open ) {
+        r.slave_open = false;
+
+        tlm::tlm_phase   phase = tlm::END_RESP;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        init_socket[r.slave]->nb_transport_fw( trans, phase, delay );
+    }
+}
+
+bus_ca::route& bus_ca::route_of( tlm::tlm_generic_payload& trans )
+{
+    route* r = trans.get_extension<route>();
+    if( !r ) {
+        // sticky extension, lives as long as the payload
+        r = new route;
+        trans.set_extension( r );
+    }
+    return *r;
+}
+
+// stuff for address decoding
+void bus_ca::end_of_elaboration()
+{
+    address_map( init_socket.size(), mem_map.c_str() ).swap( targets );
+
+    sc_assert( init_socket.size() == targets.size() );
+
+    decoded.assign( target_socket.size(), decode_cache() );
+
+    request_queue.resize( init_socket.size() );
+    request_open.assign( init_socket.size(), NULL );
+    request_ready.assign( init_socket.size(), sc_core::SC_ZERO_TIME );
+
+    response_queue.resize( target_socket.size() );
+    response_open.assign( target_socket.size(), NULL );
+}
 
 /* vim: set ts=4 sw=4 tw=72 et :*/
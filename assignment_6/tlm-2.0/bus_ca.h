@@ -1,13 +1,112 @@
 #ifndef BUS_CA_H_INCLUDED_
 #define BUS_CA_H_INCLUDED_
 
+#include "address_map.h"
+#include "decode_cache.h"
+
+#include <deque>
+#include <string>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 #include <systemc>
 
-// FILLME: implement bus_ca, based on 'bus' implementation
+#include <tlm_utils/multi_passthrough_target_socket.h>
+#include <tlm_utils/multi_passthrough_initiator_socket.h>
+#include <tlm_utils/peq_with_get.h>
+#include <tlm.h>
+
+// Approximately-timed interconnect component
+//
+// Implements the four phases of the base protocol on both sides.  A
+// request is accepted (END_REQ) as soon as it becomes visible on the
+// bus, so every initiator may have several transactions outstanding.
+// Each slave has its own request queue and each master its own
+// response queue, i.e. requests to and responses from different
+// slaves overlap.  Blocking masters are served by b_transport, which
+// converts the call into the same four-phase sequence.
+struct bus_ca
+: public sc_core::sc_module
+{
+    typedef bus_ca             this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::multi_passthrough_initiator_socket<this_type> init_socket;
+    tlm_utils::multi_passthrough_target_socket<this_type>    target_socket;
+
+    SC_HAS_PROCESS(this_type);
+    bus_ca( sc_core::sc_module_name = sc_core::sc_gen_unique_name("bus_ca"),
+            const char* mem_map = "mem_map.txt",
+            sc_core::sc_time cycle = sc_core::sc_time( 10, sc_core::SC_NS ) );
+
+private:
+    // Approximately-Timed (Non-Blocking Transport)
+    virtual tlm::tlm_sync_enum
+    nb_transport_fw( int id, tlm::tlm_generic_payload& trans,
+                     tlm::tlm_phase& phase, sc_core::sc_time& delay );
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( int id, tlm::tlm_generic_payload& trans,
+                     tlm::tlm_phase& phase, sc_core::sc_time& delay );
+
+    // LT-to-AT adapter for blocking masters
+    virtual void b_transport( int id, tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    // Debug transport, in zero time (see debug_transport.h)
+    virtual unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
+    // processes
+    void request_thread();
+    void response_thread();
+
+    // helpers
+    void send_request( unsigned slave );
+    void send_response( unsigned master );
+    void complete( tlm::tlm_generic_payload& trans );
+
+    // stuff for address decoding
+    virtual void end_of_elaboration();
+
+    std::string mem_map;
+    address_map targets;
+    std::vector<decode_cache> decoded;
+
+    // forwarding time of a request
+    sc_core::sc_time cycle;
+
+    // state of a transaction on its way through the bus, attached to
+    // the payload and kept with it (recycled by pooled payloads)
+    struct route : tlm::tlm_extension<route> {
+        unsigned                  master;
+        unsigned                  slave;
+        address_map::address_type addr;
+        // slave needs an END_RESP
+        bool                      slave_open;
+        // set for transactions of blocking masters
+        sc_core::sc_event*        done;
+
+        virtual tlm::tlm_extension_base* clone() const
+        { return new route( *this ); }
+        virtual void copy_from( tlm::tlm_extension_base const & that )
+        { *this = static_cast< route const & >( that ); }
+    };
+    static route& route_of( tlm::tlm_generic_payload& trans );
+
+    // requests visible on the bus, responses from the slaves
+    tlm_utils::peq_with_get<tlm::tlm_generic_payload> request_peq;
+    tlm_utils::peq_with_get<tlm::tlm_generic_payload> response_peq;
+
+    // per slave: waiting requests, request phase in progress
+    std::vector< std::deque<tlm::tlm_generic_payload*> > request_queue;
+    std::vector<tlm::tlm_generic_payload*>               request_open;
+    std::vector<sc_core::sc_time>                        request_ready;
+    sc_core::sc_event                                    request_free;
 
+    // per master: waiting responses, response phase in progress
+    std::vector< std::deque<tlm::tlm_generic_payload*> > response_queue;
+    std::vector<tlm::tlm_generic_payload*>               response_open;
+    sc_core::sc_event                                    response_free;
+};
 
-#endif // BUS_H_INCLUDED_
+#endif // BUS_CA_H_INCLUDED_
 
 /* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,433 @@
+#include "cache.h"
+#include "settings.h"
+
+#include <algorithm> // std::min
+#include <cstring>   // std::memcpy
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+cache_config::cache_config()
+: size( 1024 )
+, ways( 4 )
+, line( 8 )
+, replacement( lru )
+, write_back( true )
+, write_allocate( true )
+, latency( 1 )
+, seed( 1 )
+{}
+
+bool cache_config::parse( const char* spec )
+{
+    return parse_settings( spec, "Cache",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool cache_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "replace" ) {
+        if( value == "lru" )         replacement = lru;
+        else if( value == "plru" )   replacement = plru;
+        else if( value == "random" ) replacement = random;
+        else return false;
+        return true;
+    } else if( key == "write" ) {
+        if( value == "back" )         write_back = true;
+        else if( value == "through" ) write_back = false;
+        else return false;
+        return true;
+    } else if( key == "size" ) {
+        ok = ( in >> size ) && size > 0;
+    } else if( key == "ways" ) {
+        ok = ( in >> ways ) && ways > 0;
+    } else if( key == "line" ) {
+        ok = ( in >> line ) && line > 0;
+    } else if( key == "allocate" ) {
+        ok = bool( in >> write_allocate );
+    } else if( key == "latency" ) {
+        ok = ( in >> latency ) && latency >= 0;
+    } else if( key == "seed" ) {
+        ok = bool( in >> seed );
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+cache::cache( sc_core::sc_module_name /* unused */, const cache_config& config )
+: base_type()
+, target_socket("target_socket")
+, init_socket("init_socket")
+, config( config )
+, sets( config.size / ( config.ways * config.line ) )
+, latency( config.latency, sc_core::SC_NS )
+, lines()
+, data()
+, plru()
+, clock()
+, random( config.seed )
+, port()
+, stats()
+, write_backs()
+, downstream_bytes()
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+
+    if( !sets || config.size % ( config.ways * config.line ) ) {
+        std::stringstream s;
+        s << "size " << config.size << " is no multiple of "
+          << config.ways << " ways of " << config.line << " words";
+        SC_REPORT_ERROR( "Cache/Config", s.str().c_str() );
+    }
+    if( config.replacement == cache_config::plru
+        && ( config.ways & ( config.ways - 1 ) ) ) {
+        SC_REPORT_ERROR( "Cache/Config",
+                         "pseudo-LRU needs a power of two ways" );
+    }
+
+    lines.resize( std::size_t( sets ) * config.ways );
+    data.resize( lines.size() * config.line );
+    plru.resize( std::size_t( sets ) * ( config.ways - 1 ) );
+}
+
+void cache::end_of_elaboration()
+{
+    stats.resize( target_socket.size() );
+}
+
+void cache::b_transport( int id, tlm::tlm_generic_payload& trans,
+                         sc_core::sc_time& delay )
+{
+    initiator_stats& st = stats[id];
+
+    sc_dt::uint64  addr   = trans.get_address();
+    unsigned       length = trans.get_data_length();
+    unsigned char* bytes  = trans.get_data_ptr();
+    bool           write  = trans.is_write();
+
+    st.bytes += length;
+    port.lock();
+
+    // plain bursts of whole words only
+    if( !( trans.is_read() || write ) || trans.get_byte_enable_ptr()
+        || !length || length % sizeof(unsigned)
+        || trans.get_streaming_width() < length ) {
+        ++st.uncached;
+        write_back_range( addr, ( length + sizeof(unsigned) - 1 ) / sizeof(unsigned),
+                          write, delay );
+        forward( trans, delay );
+        trans.set_dmi_allowed( false );
+        port.unlock();
+        return;
+    }
+
+    unsigned words   = length / sizeof(unsigned);
+    bool     through = write && !config.write_back;
+    bool     failed  = false;
+
+    for( unsigned done = 0; done < words; ) {
+        sc_dt::uint64 a         = addr + done;
+        sc_dt::uint64 line_addr = a - a % config.line;
+        unsigned      n = std::min< sc_dt::uint64 >( words - done,
+                                                     line_addr + config.line - a );
+
+        int index = lookup( line_addr );
+        if( index >= 0 ) {
+            ++( write ? st.write_hits : st.read_hits );
+        } else {
+            ++( write ? st.write_misses : st.read_misses );
+            if( !write || config.write_allocate ) {
+                index = fill( line_addr, st, delay );
+                if( index < 0 ) {
+                    failed = true;
+                    break;
+                }
+            } else {
+                through = true; // no write allocate
+            }
+        }
+
+        if( index >= 0 ) {
+            unsigned* word = data_of( index ) + ( a - line_addr );
+            if( write ) {
+                std::memcpy( word, bytes + done * sizeof(unsigned),
+                             n * sizeof(unsigned) );
+                lines[index].dirty = config.write_back;
+            } else {
+                std::memcpy( bytes + done * sizeof(unsigned), word,
+                             n * sizeof(unsigned) );
+            }
+            touch( index );
+        }
+        done += n;
+    }
+
+    if( failed ) {
+        // let the target report the error, on up-to-date memory
+        ++st.uncached;
+        write_back_range( addr, words, write, delay );
+        forward( trans, delay );
+    } else if( through ) {
+        forward( trans, delay );
+    } else {
+        trans.set_response_status( tlm::TLM_OK_RESPONSE );
+    }
+
+    delay += latency;
+    trans.set_dmi_allowed( false );
+    port.unlock();
+}
+
+bool cache::get_direct_mem_ptr( int /* id unused */,
+                                tlm::tlm_generic_payload& /* trans unused */,
+                                tlm::tlm_dmi& /* dmi unused */ )
+{
+    // the default DMI object denies the whole address range
+    return false;
+}
+
+unsigned int cache::transport_dbg( int /* id unused */,
+                                  tlm::tlm_generic_payload& trans )
+{
+    sc_dt::uint64  addr   = trans.get_address();
+    unsigned       length = trans.get_data_length();
+    unsigned char* bytes  = trans.get_data_ptr();
+    bool           write  = trans.is_write();
+
+    if( !( trans.is_read() || write ) || trans.get_byte_enable_ptr()
+        || length % sizeof(unsigned) || trans.get_streaming_width() < length ) {
+        // memory has to be up to date, and no stale copy may remain
+        // after a write
+        unsigned words = ( length + sizeof(unsigned) - 1 ) / sizeof(unsigned);
+        for( sc_dt::uint64 line_addr = addr - addr % config.line;
+             words && line_addr < addr + words; line_addr += config.line ) {
+            int index = lookup( line_addr );
+            if( index < 0 )
+                continue;
+            if( lines[index].dirty
+                && transfer( tlm::TLM_WRITE_COMMAND, line_addr, index, NULL ) )
+                lines[index].dirty = false;
+            if( write && !lines[index].dirty )
+                lines[index].valid = false;
+        }
+        return init_socket->transport_dbg( trans );
+    }
+
+    unsigned int done  = init_socket->transport_dbg( trans );
+    unsigned     words = done / sizeof(unsigned);
+
+    // the cached copies are the current ones
+    for( unsigned i = 0; i < words; ) {
+        sc_dt::uint64 a         = addr + i;
+        sc_dt::uint64 line_addr = a - a % config.line;
+        unsigned      n = std::min< sc_dt::uint64 >( words - i,
+                                                     line_addr + config.line - a );
+
+        int index = lookup( line_addr );
+        if( index >= 0 ) {
+            unsigned* word = data_of( index ) + ( a - line_addr );
+            if( write )
+                std::memcpy( word, bytes + i * sizeof(unsigned),
+                             n * sizeof(unsigned) );
+            else if( lines[index].dirty )
+                std::memcpy( bytes + i * sizeof(unsigned), word,
+                             n * sizeof(unsigned) );
+        }
+        i += n;
+    }
+    return done;
+}
+
+int cache::lookup( sc_dt::uint64 line_addr ) const
+{
+    unsigned      first = set_of( line_addr ) * config.ways;
+    sc_dt::uint64 tag   = tag_of( line_addr );
+
+    for( unsigned i = first; i < first + config.ways; ++i )
+        if( lines[i].valid && lines[i].tag == tag )
+            return i;
+    return -1;
+}
+
+int cache::fill( sc_dt::uint64 line_addr, initiator_stats& st,
+                 sc_core::sc_time& delay )
+{
+    unsigned index = victim( set_of( line_addr ) );
+    line_state& l = lines[index];
+
+    if( l.valid ) {
+        ++st.evictions;
+        if( l.dirty && !write_back( index, delay ) )
+            SC_REPORT_WARNING( "Cache/Write back", "dirty line lost" );
+    }
+
+    l.valid = false;
+    if( !transfer( tlm::TLM_READ_COMMAND, line_addr, index, &delay ) )
+        return -1;
+
+    l.tag   = tag_of( line_addr );
+    l.valid = true;
+    l.dirty = false;
+    return index;
+}
+
+int cache::victim( unsigned set )
+{
+    unsigned first = set * config.ways;
+    for( unsigned i = first; i < first + config.ways; ++i )
+        if( !lines[i].valid )
+            return i;
+
+    switch( config.replacement ) {
+    case cache_config::lru: {
+        unsigned oldest = first;
+        for( unsigned i = first + 1; i < first + config.ways; ++i )
+            if( lines[i].used < lines[oldest].used )
+                oldest = i;
+        return oldest;
+    }
+
+    case cache_config::plru: {
+        // follow the tree bits towards the less recently used half
+        const std::size_t bits = std::size_t( set ) * ( config.ways - 1 );
+        unsigned node = 0, lo = 0, hi = config.ways;
+        while( hi - lo > 1 ) {
+            unsigned mid   = ( lo + hi ) / 2;
+            bool     right = plru[ bits + node ];
+            node = 2 * node + 1 + right;
+            ( right ? lo : hi ) = mid;
+        }
+        return first + lo;
+    }
+
+    case cache_config::random:
+        break;
+    }
+    return first + random.below( config.ways );
+}
+
+void cache::touch( unsigned index )
+{
+    lines[index].used = ++clock;
+
+    if( config.replacement != cache_config::plru )
+        return;
+
+    // point the tree bits on the path to this way away from it
+    const std::size_t bits = std::size_t( index / config.ways ) * ( config.ways - 1 );
+    unsigned way  = index % config.ways;
+    unsigned node = 0, lo = 0, hi = config.ways;
+    while( hi - lo > 1 ) {
+        unsigned mid   = ( lo + hi ) / 2;
+        bool     right = way >= mid;
+        plru[ bits + node ] = !right;
+        node = 2 * node + 1 + right;
+        ( right ? lo : hi ) = mid;
+    }
+}
+
+bool cache::write_back( unsigned index, sc_core::sc_time& delay )
+{
+    ++write_backs;
+    lines[index].dirty = false;
+    return transfer( tlm::TLM_WRITE_COMMAND, address_of( index ), index, &delay );
+}
+
+void cache::write_back_range( sc_dt::uint64 addr, unsigned words, bool drop,
+                              sc_core::sc_time& delay )
+{
+    if( !words )
+        return;
+
+    for( sc_dt::uint64 line_addr = addr - addr % config.line;
+         line_addr < addr + words; line_addr += config.line ) {
+        int index = lookup( line_addr );
+        if( index < 0 )
+            continue;
+        if( lines[index].dirty )
+            write_back( index, delay );
+        if( drop )
+            lines[index].valid = false;
+    }
+}
+
+bool cache::transfer( tlm::tlm_command command, sc_dt::uint64 line_addr,
+                      unsigned index, sc_core::sc_time* delay )
+{
+    unsigned length = config.line * sizeof(unsigned);
+
+    tlm::tlm_generic_payload trans;
+    trans.set_command( command );
+    trans.set_address( line_addr );
+    trans.set_data_ptr( reinterpret_cast< unsigned char* >( data_of( index ) ) );
+    trans.set_data_length( length );
+    trans.set_streaming_width( length );
+    trans.set_byte_enable_ptr( NULL );
+    trans.set_dmi_allowed( false );
+    trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    if( !delay )
+        return init_socket->transport_dbg( trans ) == length;
+
+    init_socket->b_transport( trans, *delay );
+    downstream_bytes += length;
+
+    return !trans.is_response_error();
+}
+
+void cache::forward( tlm::tlm_generic_payload& trans, sc_core::sc_time& delay )
+{
+    init_socket->b_transport( trans, delay );
+    downstream_bytes += trans.get_data_length();
+}
+
+unsigned cache::set_of( sc_dt::uint64 line_addr ) const
+{
+    return ( line_addr / config.line ) % sets;
+}
+
+sc_dt::uint64 cache::tag_of( sc_dt::uint64 line_addr ) const
+{
+    return ( line_addr / config.line ) / sets;
+}
+
+sc_dt::uint64 cache::address_of( unsigned index ) const
+{
+    return ( lines[index].tag * sets + index / config.ways ) * config.line;
+}
+
+void cache::end_of_simulation()
+{
+    unsigned long long requested = 0;
+    unsigned long      evictions = 0;
+    for( unsigned id = 0; id < stats.size(); ++id ) {
+        const initiator_stats& s = stats[id];
+        unsigned long hits     = s.read_hits + s.write_hits;
+        unsigned long accesses = hits + s.read_misses + s.write_misses;
+        requested += s.bytes;
+        evictions += s.evictions;
+
+        std::cout << name() << " initiator " << id << ": "
+                  << s.read_hits << "/" << s.read_misses << " read hits/misses, "
+                  << s.write_hits << "/" << s.write_misses << " write hits/misses, "
+                  << s.evictions << " evictions, "
+                  << s.uncached << " uncached";
+        if( accesses )
+            std::cout << " (hit rate " << 100. * hits / accesses << "%)";
+        std::cout << std::endl;
+    }
+    std::cout << name() << ": " << evictions << " evictions, "
+              << write_backs << " write-backs, "
+              << requested << " bytes requested, "
+              << downstream_bytes << " bytes downstream" << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
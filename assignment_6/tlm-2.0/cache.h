@@ -0,0 +1,163 @@
+#ifndef CACHE_H_INCLUDED_
+#define CACHE_H_INCLUDED_
+
+#include "prng.h"
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+#include <tlm_utils/simple_initiator_socket.h>
+
+#include <string>
+#include <vector>
+
+// Configuration of a cache, from a list of 'key=value' settings (see
+// settings.h); sizes are in words, like addresses (see ram.h):
+//
+//   size=<n>     capacity (default: 1024)
+//   ways=<n>     associativity (default: 4)
+//   line=<n>     line size (default: 8)
+//   replace=<p>  lru, plru (needs a power of two ways) or random
+//                (default: lru)
+//   write=<p>    back or through (default: back)
+//   allocate=<b> allocate lines on write misses, 0 or 1 (default: 1)
+//   latency=<ns> hit latency (default: 1)
+//   seed=<n>     seed of the random replacement (default: 1)
+struct cache_config
+{
+    enum replacement_type { lru, plru, random };
+
+    cache_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned         size;
+    unsigned         ways;
+    unsigned         line;
+    replacement_type replacement;
+    bool             write_back;
+    bool             write_allocate;
+    double           latency;
+    unsigned         seed;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// Set-associative cache between initiators and the interconnect
+//
+// Plain read and write bursts are served from the cache, misses fetch
+// whole lines with line-sized bursts from init_socket.  Transactions
+// with byte enables or streaming widths, and those the line fetch
+// fails for (e.g. lines crossing the end of a slave), are passed on
+// uncached, after writing back the dirty lines they overlap.
+//
+// DMI is denied, as direct accesses would bypass the cache.  Debug
+// transport reads the dirty lines it overlaps and updates the cached
+// copies it writes, neither counts as a hit or miss.  Dirty lines are
+// not written back at the end of simulation.
+struct cache
+: public sc_core::sc_module
+{
+    typedef cache              this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::multi_passthrough_target_socket<this_type> target_socket;
+    tlm_utils::simple_initiator_socket<this_type>         init_socket;
+
+    cache( sc_core::sc_module_name, const cache_config& config );
+
+private:
+    struct line_state
+    {
+        line_state() : tag(), valid(), dirty(), used() {}
+
+        sc_dt::uint64      tag;
+        bool               valid;
+        bool               dirty;
+        unsigned long long used; // LRU stamp
+    };
+
+    // per initiator, hits and misses count the lines an access touches,
+    // evictions are charged to the initiator whose miss caused them
+    struct initiator_stats
+    {
+        initiator_stats()
+        : read_hits(), read_misses(), write_hits(), write_misses()
+        , evictions(), uncached(), bytes()
+        {}
+
+        unsigned long      read_hits;
+        unsigned long      read_misses;
+        unsigned long      write_hits;
+        unsigned long      write_misses;
+        unsigned long      evictions;
+        unsigned long      uncached;
+        unsigned long long bytes;
+    };
+
+    // Loosely-Timed (Blocking Transport)
+    void b_transport( int id, tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay );
+
+    // Direct Memory Interface (denied)
+    bool get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                             tlm::tlm_dmi& dmi );
+
+    // Debug transport, on the memory behind the cache and the lines
+    // holding the range, in zero time
+    unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
+    virtual void end_of_elaboration();
+    virtual void end_of_simulation();
+
+    // line holding 'line_addr', or -1
+    int  lookup( sc_dt::uint64 line_addr ) const;
+    // line allocated for 'line_addr' and filled, or -1 on errors; the
+    // eviction, if any, counts for 'st'
+    int  fill( sc_dt::uint64 line_addr, initiator_stats& st,
+               sc_core::sc_time& delay );
+    int  victim( unsigned set );
+    void touch( unsigned index );
+
+    bool write_back( unsigned index, sc_core::sc_time& delay );
+    // before passing on an uncached access: writes back the dirty lines
+    // overlapping it, and drops them if the access is a write
+    void write_back_range( sc_dt::uint64 addr, unsigned words, bool drop,
+                           sc_core::sc_time& delay );
+
+    // line-sized burst to or from the line's data; by debug transport,
+    // in zero time, without 'delay'
+    bool transfer( tlm::tlm_command command, sc_dt::uint64 line_addr,
+                   unsigned index, sc_core::sc_time* delay );
+
+    void forward( tlm::tlm_generic_payload& trans, sc_core::sc_time& delay );
+
+    unsigned         set_of( sc_dt::uint64 line_addr ) const;
+    sc_dt::uint64    tag_of( sc_dt::uint64 line_addr ) const;
+    sc_dt::uint64    address_of( unsigned index ) const;
+    unsigned*        data_of( unsigned index )
+    { return &data[ std::size_t( index ) * config.line ]; }
+
+    cache_config     config;
+    unsigned         sets;
+    sc_core::sc_time latency;
+
+    std::vector<line_state> lines;    // sets * ways
+    std::vector<unsigned>   data;     // sets * ways * line words
+    std::vector<bool>       plru;     // sets * (ways - 1) tree bits
+    unsigned long long      clock;    // LRU stamps
+    prng                    random;
+
+    // one request at a time, fills may block in the interconnect
+    sc_core::sc_mutex       port;
+
+    std::vector<initiator_stats> stats;
+    unsigned long                write_backs;
+    unsigned long long           downstream_bytes;
+};
+
+#endif // CACHE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,212 @@
+#include "capture_file.h"
+
+#include <cstring> // std::memcmp
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+namespace capture {
+
+namespace {
+
+const unsigned char magic[4]    = { 'T', 'L', 'M', 'C' };
+const unsigned char version     = 1;
+const std::size_t   header_size = 8;
+
+// records are written in blocks of this size
+const std::size_t   block_size  = 1 << 20;
+
+std::uint64_t zigzag( std::uint64_t delta )
+{ return ( delta << 1 ) ^ ( std::int64_t( delta ) < 0 ? ~std::uint64_t() : 0 ); }
+
+std::uint64_t unzigzag( std::uint64_t value )
+{ return ( value >> 1 ) ^ ( ~( value & 1 ) + 1 ); }
+
+} // anonymous namespace
+
+writer::writer()
+: file( NULL )
+, buffer()
+, delta_encoded()
+, last_time()
+, last_address()
+{}
+
+writer::~writer()
+{
+    close();
+}
+
+bool writer::open( const char* filename, bool delta )
+{
+    close();
+
+    file = std::fopen( filename, "wb" );
+    if( !file )
+        return false;
+
+    delta_encoded = delta;
+    last_time     = 0;
+    last_address  = 0;
+
+    buffer.clear();
+    buffer.reserve( block_size + 64 );
+    buffer.insert( buffer.end(), magic, magic + sizeof(magic) );
+    buffer.push_back( version );
+    buffer.push_back( delta ? capture::delta : 0 );
+    buffer.push_back( 0 );
+    buffer.push_back( 0 );
+    return true;
+}
+
+void writer::close()
+{
+    if( !file )
+        return;
+
+    flush();
+    std::fclose( file );
+    file = NULL;
+}
+
+void writer::write( const record& r )
+{
+    if( !file )
+        return;
+
+    buffer.push_back( ( r.command & command_mask ) | ( r.data ? has_data : 0 ) );
+    if( delta_encoded ) {
+        put( r.time - last_time );
+        put( zigzag( r.address - last_address ) );
+        last_time    = r.time;
+        last_address = r.address;
+    } else {
+        put( r.time );
+        put( r.address );
+    }
+    put( r.length );
+    if( r.data )
+        buffer.insert( buffer.end(), r.data, r.data + r.length );
+
+    if( buffer.size() >= block_size )
+        flush();
+}
+
+void writer::put( std::uint64_t value )
+{
+    while( value >= 0x80 ) {
+        buffer.push_back( ( value & 0x7F ) | 0x80 );
+        value >>= 7;
+    }
+    buffer.push_back( value );
+}
+
+void writer::flush()
+{
+    if( !buffer.empty() )
+        std::fwrite( &buffer[0], 1, buffer.size(), file );
+    buffer.clear();
+}
+
+reader::reader()
+: base( NULL )
+, size()
+, offset()
+, delta_encoded()
+, last_time()
+, last_address()
+{}
+
+reader::~reader()
+{
+    close();
+}
+
+bool reader::open( const char* filename )
+{
+    close();
+
+    int fd = ::open( filename, O_RDONLY );
+    if( fd < 0 )
+        return false;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+    if( fstat( fd, &st ) == 0 && std::size_t( st.st_size ) >= header_size )
+        map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+
+    if( map == MAP_FAILED )
+        return false;
+
+    base = static_cast< const unsigned char* >( map );
+    size = st.st_size;
+
+    if( std::memcmp( base, magic, sizeof(magic) ) || base[4] != version ) {
+        close();
+        return false;
+    }
+
+    // read once, front to back
+    madvise( map, size, MADV_SEQUENTIAL );
+
+    delta_encoded = base[5] & capture::delta;
+    offset        = header_size;
+    last_time     = 0;
+    last_address  = 0;
+    return true;
+}
+
+void reader::close()
+{
+    if( base )
+        munmap( const_cast< unsigned char* >( base ), size );
+    base = NULL;
+    size = 0;
+}
+
+bool reader::next( record& r )
+{
+    if( !base || offset >= size )
+        return false;
+
+    unsigned char kind = base[offset++];
+    std::uint64_t time, address;
+    if( !get( time ) || !get( address ) || !get( r.length ) )
+        return false;
+
+    if( delta_encoded ) {
+        time    = last_time    += time;
+        address = last_address += unzigzag( address );
+    }
+    r.command = kind & command_mask;
+    r.time    = time;
+    r.address = address;
+    r.data    = NULL;
+
+    if( kind & has_data ) {
+        if( r.length > size - offset )
+            return false;
+        r.data  = base + offset;
+        offset += r.length;
+    }
+    return true;
+}
+
+bool reader::get( std::uint64_t& value )
+{
+    value = 0;
+    for( unsigned shift = 0; offset < size && shift < 64; shift += 7 ) {
+        unsigned char byte = base[offset++];
+        value |= std::uint64_t( byte & 0x7F ) << shift;
+        if( !( byte & 0x80 ) )
+            return true;
+    }
+    return false;
+}
+
+} // namespace capture
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,103 @@
+#ifndef CAPTURE_FILE_H_INCLUDED_
+#define CAPTURE_FILE_H_INCLUDED_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>  // std::FILE
+#include <vector>
+
+// Binary transaction capture
+//
+// A capture starts with an 8 byte header: the magic "TLMC", a format
+// version, a flags byte and two reserved bytes.  One record per
+// transaction follows:
+//
+//   kind    1 byte: command (bits 0-1), data follows (bit 2)
+//   time    issue time in ps, varint
+//   address varint
+//   length  data length in bytes, varint
+//   data    'length' bytes, if flagged (written resp. read data)
+//
+// Varints are LEB128 (7 bits per byte, least significant first).  With
+// the 'delta' flag, time and address are stored relative to those of
+// the previous record, the address as a zigzag encoded signed value,
+// which keeps records of sequential traffic to a few bytes.
+namespace capture {
+
+enum header_flags
+{
+    delta = 1
+};
+
+enum record_kind
+{
+    command_mask = 3,
+    has_data     = 4
+};
+
+struct record
+{
+    unsigned             command; // tlm::tlm_command
+    std::uint64_t        time;    // ps
+    std::uint64_t        address;
+    std::uint64_t        length;
+    const unsigned char* data;    // NULL, or 'length' bytes
+};
+
+// Buffered writer, blocks of the capture are written with single
+// fwrite() calls
+class writer
+{
+public:
+    writer();
+    ~writer();
+
+    bool open( const char* filename, bool delta );
+    void close();
+
+    bool is_open() const
+    { return file != NULL; }
+
+    void write( const record& r );
+
+private:
+    void put( std::uint64_t value );
+    void flush();
+
+    std::FILE*                 file;
+    std::vector<unsigned char> buffer;
+    bool                       delta_encoded;
+    std::uint64_t              last_time;
+    std::uint64_t              last_address;
+};
+
+// Reader on a read-only memory mapping of the capture, the data of
+// the records points into the mapping
+class reader
+{
+public:
+    reader();
+    ~reader();
+
+    bool open( const char* filename );
+    void close();
+
+    // false at the end of the capture, or on a truncated record
+    bool next( record& r );
+
+private:
+    bool get( std::uint64_t& value );
+
+    const unsigned char* base;
+    std::size_t          size;
+    std::size_t          offset;
+    bool                 delta_encoded;
+    std::uint64_t        last_time;
+    std::uint64_t        last_address;
+};
+
+} // namespace capture
+
+#endif // CAPTURE_FILE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
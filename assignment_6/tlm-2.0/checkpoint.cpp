@@ -0,0 +1,145 @@
+#include "checkpoint.h"
+
+#include <algorithm> // std::equal
+#include <cstdio>    // std::rename, std::remove
+#include <fstream>   // std::ifstream, std::ofstream
+#include <iostream>  // std::cout, std::cerr, std::endl
+#include <sstream>   // std::stringstream
+
+namespace {
+
+const char magic[8] = { 'T', 'L', 'M', 'C', 'K', 'P', 'T', '1' };
+
+void put( std::ostream& out, sc_dt::uint64 value )
+{
+    out.write( reinterpret_cast< const char* >( &value ), sizeof(value) );
+}
+
+bool get( std::istream& in, sc_dt::uint64& value )
+{
+    return bool( in.read( reinterpret_cast< char* >( &value ), sizeof(value) ) );
+}
+
+} // anonymous namespace
+
+checkpoint& checkpoint::instance()
+{
+    static checkpoint the_checkpoint;
+    return the_checkpoint;
+}
+
+checkpoint::checkpoint()
+: components()
+, states()
+, loaded( false )
+, restored()
+{}
+
+void checkpoint::add( const std::string& name, checkpointable& state )
+{
+    components[name] = &state;
+    if( !loaded )
+        return;
+
+    std::map< std::string, checkpointable::state_type >::const_iterator it
+        = states.find( name );
+    if( it == states.end() ) {
+        std::stringstream s;
+        s << "no saved state for " << name << ", it starts afresh";
+        SC_REPORT_WARNING( "Checkpoint/Restore", s.str().c_str() );
+    } else if( !state.restore_state( it->second ) ) {
+        std::stringstream s;
+        s << "the saved state does not fit " << name
+          << ", restore with the options of the checkpointed run";
+        SC_REPORT_ERROR( "Checkpoint/Restore", s.str().c_str() );
+    }
+}
+
+bool checkpoint::save( const char* prefix )
+{
+    // written aside first, the rams may map the images of the
+    // checkpoint restored before
+    std::string   temp = std::string( prefix ) + ".tmp";
+    std::ofstream out( temp.c_str(), std::ios::binary );
+    if( !out ) {
+        std::cerr << "cannot write checkpoint " << prefix << std::endl;
+        return false;
+    }
+
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    out.write( magic, sizeof(magic) );
+    put( out, sc_dt::uint64( now.to_seconds() * 1e12 + .5 ) ); // ps
+    put( out, components.size() );
+
+    std::map< std::string, checkpointable* >::const_iterator it;
+    for( it = components.begin(); it != components.end(); ++it ) {
+        checkpointable::state_type state;
+        if( !it->second->save_state( state, prefix ) ) {
+            std::cerr << "cannot save the state of " << it->first
+                      << " to checkpoint " << prefix << std::endl;
+            std::remove( temp.c_str() );
+            return false;
+        }
+
+        put( out, it->first.size() );
+        out.write( it->first.data(), it->first.size() );
+        put( out, state.size() );
+        for( std::size_t i = 0; i < state.size(); ++i )
+            put( out, state[i] );
+    }
+
+    out.close();
+    if( !out || std::rename( temp.c_str(), prefix ) ) {
+        std::cerr << "cannot write checkpoint " << prefix << std::endl;
+        std::remove( temp.c_str() );
+        return false;
+    }
+
+    std::cout << "checkpoint " << prefix << " at " << now << ": "
+              << components.size() << " components" << std::endl;
+    return true;
+}
+
+bool checkpoint::load( const char* prefix )
+{
+    std::ifstream in( prefix, std::ios::binary );
+    char          header[ sizeof(magic) ] = {};
+    sc_dt::uint64 time, count;
+
+    in.read( header, sizeof(header) );
+    if( !in || !std::equal( header, header + sizeof(header), magic )
+        || !get( in, time ) || !get( in, count ) ) {
+        std::cerr << prefix << ": no checkpoint" << std::endl;
+        return false;
+    }
+
+    states.clear();
+    for( sc_dt::uint64 c = 0; c < count; ++c ) {
+        sc_dt::uint64 length, size, value;
+        if( !get( in, length ) ) {
+            std::cerr << prefix << ": truncated checkpoint" << std::endl;
+            return false;
+        }
+        std::string name( length, '\0' );
+        in.read( &name[0], length );
+
+        checkpointable::state_type& state = states[name];
+        bool ok = in && get( in, size );
+        for( sc_dt::uint64 i = 0; ok && i < size; ++i ) {
+            ok = get( in, value );
+            state.push_back( value );
+        }
+        if( !ok ) {
+            std::cerr << prefix << ": truncated checkpoint" << std::endl;
+            return false;
+        }
+    }
+
+    loaded   = true;
+    restored = sc_core::sc_time( double( time ), sc_core::SC_PS );
+    std::cout << "restoring checkpoint " << prefix << " at " << restored
+              << ": " << states.size() << " components" << std::endl;
+    return true;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_H_INCLUDED_
+#define CHECKPOINT_H_INCLUDED_
+
+#include <systemc>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// State of a component that survives a checkpoint
+struct checkpointable
+{
+    typedef std::vector<sc_dt::uint64> state_type;
+
+    virtual ~checkpointable() {}
+
+    // appends the state to 'state'; bulk data (e.g. ram contents) goes
+    // to files named '<prefix>.<component>'
+    virtual bool save_state( state_type& state, const std::string& prefix ) = 0;
+
+    // takes the state saved before, during elaboration; false if it
+    // does not fit the component
+    virtual bool restore_state( const state_type& state ) = 0;
+};
+
+// Checkpoints of the platform (main's -k and -K options)
+//
+// Components register their state under their name when they are
+// constructed.  A checkpoint is the file '<prefix>', holding the
+// simulation time and the state of every registered component as a
+// list of numbers (in host byte order), plus the image files
+// '<prefix>.<ram>' of the rams (see ram.h).
+//
+// Restoring loads '<prefix>' before the platform is elaborated again,
+// with the same options: every component registering takes its saved
+// state right away.  The rams map their images copy-on-write (see
+// mapped_storage), so restoring takes no time for any size.  The
+// initiators wait until the saved time before they resume, there is
+// no way to set the kernel's time directly.
+//
+// Only what is in flight is lost: an access that has not completed at
+// the checkpoint is issued again after restoring.
+class checkpoint
+{
+public:
+    static checkpoint& instance();
+
+    // registers 'state' as 'name', restoring it if a checkpoint was
+    // loaded
+    void add( const std::string& name, checkpointable& state );
+
+    // writes a checkpoint at the current time, false on errors
+    bool save( const char* prefix );
+
+    // reads a checkpoint, before elaboration; false on errors
+    bool load( const char* prefix );
+
+    bool restoring() const
+    { return loaded; }
+
+    // time of the loaded checkpoint, where the initiators resume
+    const sc_core::sc_time& time() const
+    { return restored; }
+
+private:
+    checkpoint();
+
+    std::map< std::string, checkpointable* >             components;
+    std::map< std::string, checkpointable::state_type > states;
+
+    bool             loaded;
+    sc_core::sc_time restored;
+};
+
+#endif // CHECKPOINT_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
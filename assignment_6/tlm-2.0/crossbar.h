@@ -3,6 +3,7 @@
 
 // include the submodules
 #include "router.h"
+#include "static_router.h"
 #include "arbiter.h"
 
 static
@@ -10,7 +11,37 @@ arbiter* arbiter_creator(const char* name, size_t){
   return new arbiter( name, 10, sc_core::SC_NS );
 }
 
-template< unsigned NumMasters, unsigned NumSlaves >
+// creates routers decoding with the memory map 'Map' known at compile
+// time (see static_address_map.h), the file name is not needed
+template< typename Map >
+struct router_creator {
+  typedef static_router< Map > router_type;
+
+  explicit router_creator( const char* /* mem_map unused */ ) {}
+
+  router_type* operator()( const char* name, size_t ) const {
+    return new router_type( name );
+  }
+};
+
+// creates routers decoding with the given memory map file
+template<>
+struct router_creator< void > {
+  typedef router router_type;
+
+  explicit router_creator( const char* mem_map ) : mem_map( mem_map ) {}
+
+  router_type* operator()( const char* name, size_t ) const {
+    return new router_type( name, mem_map );
+  }
+private:
+  const char* mem_map;
+};
+
+// Map selects the address decoding of the routers: void loads the
+// memory map file at the end of elaboration, any other type is taken
+// as the compile-time table of a static_address_map
+template< unsigned NumMasters, unsigned NumSlaves, typename Map = void >
 class crossbar
   : public sc_core::sc_module
 {
@@ -23,7 +54,8 @@ public:
   sc_core::sc_vector<tlm::tlm_initiator_socket<> > init_sockets;
   sc_core::sc_vector<tlm::tlm_target_socket<> >    target_sockets;
 
-  SC_CTOR( crossbar )
+  explicit crossbar( sc_core::sc_module_name,
+                     const char* mem_map = "mem_map.txt" )
     : init_sockets("init_sockets")
     , target_sockets("target_sockets")
     , routers("routers")
@@ -32,17 +64,33 @@ public:
     init_sockets.init( NumSlaves);
     target_sockets.init( NumMasters );
     // create one router per master
-    routers.init( NumMasters );
+    routers.init( NumMasters, router_creator< Map >( mem_map ) );
     // create one arbiter per slave
     arbiters.init( NumSlaves, arbiter_creator);
 
-    // FILLME: instantiate the routers and bind them correctly to
-    //         all arbiters
+    // every router reaches every slave through its arbiter
+    for( unsigned m = 0; m < NumMasters; ++m ) {
+      target_sockets[m].bind( routers[m].target_socket );
+      for( unsigned s = 0; s < NumSlaves; ++s )
+        routers[m].init_socket.bind( arbiters[s].target_socket );
+    }
+    for( unsigned s = 0; s < NumSlaves; ++s )
+      arbiters[s].init_socket.bind( init_sockets[s] );
   }
 
+  // arbitration of the accesses to 'slave', see arbiter.h; the
+  // arbiter's ports are the masters' indices
+  void set_policy( unsigned slave, arbiter::policy p )
+    { arbiters[slave].set_policy( p ); }
+
+  void set_weight( unsigned slave, unsigned master, unsigned weight )
+    { arbiters[slave].set_weight( master, weight ); }
+
 private:
 
-  sc_core::sc_vector< router > routers;
+  typedef typename router_creator< Map >::router_type router_type;
+
+  sc_core::sc_vector< router_type > routers;
   sc_core::sc_vector< arbiter > arbiters;
 };
 
@@ -0,0 +1,48 @@
+#ifndef DEBUG_TRANSPORT_H_INCLUDED_
+#define DEBUG_TRANSPORT_H_INCLUDED_
+
+#include <tlm.h>
+
+// Debug transport through an interconnect
+//
+// Decodes the target of the debug transaction 'trans' with 'map' (an
+// address_map or a static_address_map), and passes it on by calling
+// 'forward( target, trans )' with the address local to the target.
+// The transaction is cut at the end of the target's region, so the
+// initiator sees fewer bytes transferred and continues with the rest
+// in a second call.  Address and length are restored afterwards.
+//
+// Returns the bytes transferred, 0 if the address is not mapped.
+template< typename Map, typename Forward >
+unsigned int route_dbg( const Map& map, tlm::tlm_generic_payload& trans,
+                        Forward forward )
+{
+    typename Map::address_type addr   = trans.get_address();
+    typename Map::index_type   target = map.decode( addr );
+
+    if( target == Map::npos )
+        return 0;
+
+    // addresses are word addresses (see ram.h)
+    unsigned      length = trans.get_data_length();
+    unsigned      width  = trans.get_streaming_width();
+    sc_dt::uint64 room   = ( sc_dt::uint64( map.get_end_address( target ) )
+                             - addr + 1 ) * sizeof(unsigned);
+    if( length > room ) {
+        trans.set_data_length( unsigned( room ) );
+        if( width > room )
+            trans.set_streaming_width( unsigned( room ) );
+    }
+
+    trans.set_address( map.get_local_address( target, addr ) );
+    unsigned int done = forward( target, trans );
+
+    trans.set_address( addr );
+    trans.set_data_length( length );
+    trans.set_streaming_width( width );
+    return done;
+}
+
+#endif // DEBUG_TRANSPORT_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
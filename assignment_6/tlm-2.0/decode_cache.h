@@ -0,0 +1,58 @@
+#ifndef DECODE_CACHE_H_INCLUDED_
+#define DECODE_CACHE_H_INCLUDED_
+
+#include "address_map.h"
+
+// remembers the region an initiator decoded last, so that repeated
+// accesses to the same slave skip the address map lookup
+struct decode_cache {
+    typedef address_map::address_type address_type;
+    typedef address_map::index_type   index_type;
+
+    decode_cache()
+        : hits(0), misses(0)
+    { invalidate(); }
+
+    // returns the slave for addr (or address_map::npos)
+    index_type decode( const address_map& map, address_type addr )
+    {
+        if( start <= addr && addr <= end ) {
+            ++hits;
+            return index;
+        }
+        ++misses;
+
+        index = map.decode( addr );
+        if( index == address_map::npos ) {
+            invalidate();
+        } else {
+            start = map.get_start_address( index );
+            end   = map.get_end_address( index );
+        }
+        return index;
+    }
+
+    // translation for the region returned by the last decode() call
+    address_type get_local_address( address_type addr ) const
+    { return addr - start; }
+
+    void invalidate()
+    {
+        // empty range, never hits
+        start = 1;
+        end   = 0;
+        index = address_map::npos;
+    }
+
+    unsigned long hits;
+    unsigned long misses;
+
+private:
+    address_type start;
+    address_type end;
+    index_type   index;
+};
+
+#endif // DECODE_CACHE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
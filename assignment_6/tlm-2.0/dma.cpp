@@ -0,0 +1,321 @@
+#include "dma.h"
+#include "settings.h"
+
+#include <algorithm> // std::min
+#include <cstring>   // std::memmove
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+dma_config::dma_config()
+: burst( 16 )
+, depth( 4 )
+, dmi( true )
+, latency( 1 )
+{}
+
+bool dma_config::parse( const char* spec )
+{
+    return parse_settings( spec, "DMA",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool dma_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "burst" ) {
+        ok = ( in >> burst ) && burst > 0;
+    } else if( key == "depth" ) {
+        ok = ( in >> depth ) && depth > 0;
+    } else if( key == "dmi" ) {
+        ok = bool( in >> dmi );
+    } else if( key == "latency" ) {
+        ok = ( in >> latency ) && latency >= 0;
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+dma::dma( sc_core::sc_module_name /* unused */, const dma_config& config )
+: base_type()
+, target_socket( "target_socket" )
+, init_socket( "init_socket" )
+, irq( "irq" )
+, config( config )
+, latency( config.latency, sc_core::SC_NS )
+, desc(), ctrl(), status(), copied()
+, kick()
+, src(), dst(), words(), next(), finished(), failed()
+, work()
+, burst_done()
+, dmi_regions()
+, chains(), descriptors(), transactions(), total_words(), dmi_words()
+, busy()
+{
+    target_socket.register_b_transport( this, &this_type::b_transport );
+    target_socket.register_transport_dbg( this, &this_type::transport_dbg );
+    init_socket.register_invalidate_direct_mem_ptr(
+        this, &this_type::invalidate_direct_mem_ptr );
+
+    SC_THREAD( run );
+    for( unsigned i = 0; i < config.depth; ++i ) {
+        std::stringstream s;
+        s << "worker_" << i;
+        sc_core::sc_spawn( sc_bind( &this_type::worker, this ), s.str().c_str() );
+    }
+}
+
+void dma::run()
+{
+    irq.write( false );
+
+    for( ;; ) {
+        wait( kick );
+
+        sc_core::sc_time begin = sc_core::sc_time_stamp();
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        ++chains;
+
+        for( unsigned addr = desc; addr != end_of_chain; ) {
+            unsigned d[4];
+            if( !transfer( tlm::TLM_READ_COMMAND, addr, d, 4, delay ) ) {
+                status |= status_error;
+                break;
+            }
+            wait( delay );
+            delay = sc_core::SC_ZERO_TIME;
+            ++descriptors;
+
+            addr = d[3];
+            if( !d[2] || ( config.dmi && copy_dmi( d[0], d[1], d[2] ) ) )
+                continue;
+
+            // the workers take the bursts
+            src      = d[0];
+            dst      = d[1];
+            words    = d[2];
+            next     = 0;
+            finished = 0;
+            failed   = false;
+            work.notify();
+            while( finished < words )
+                wait( burst_done );
+
+            if( failed ) {
+                status |= status_error;
+                break;
+            }
+        }
+
+        busy  += sc_core::sc_time_stamp() - begin;
+        status = ( status & ~status_busy ) | status_done;
+        update_irq();
+    }
+}
+
+void dma::worker()
+{
+    std::vector<unsigned> buffer( config.burst );
+
+    for( ;; ) {
+        while( next >= words )
+            wait( work );
+
+        unsigned offset = next;
+        unsigned n      = std::min( config.burst, words - offset );
+        next += n;
+
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        bool ok = transfer( tlm::TLM_READ_COMMAND, src + offset,
+                            &buffer[0], n, delay )
+               && transfer( tlm::TLM_WRITE_COMMAND, dst + offset,
+                            &buffer[0], n, delay );
+        wait( delay );
+
+        if( ok ) {
+            copied      += n;
+            total_words += n;
+        } else if( !failed ) {
+            // no further bursts, the ones in flight still finish
+            failed    = true;
+            finished += words - next;
+            next      = words;
+        }
+        finished += n;
+        burst_done.notify();
+    }
+}
+
+bool dma::copy_dmi( unsigned src, unsigned dst, unsigned words )
+{
+    tlm::tlm_dmi from, to;
+    if( !find_dmi( src, src + words - 1, false, from )
+        || !find_dmi( dst, dst + words - 1, true, to ) )
+        return false;
+
+    // word addressed, see ram.h
+    std::memmove( to.get_dmi_ptr()
+                      + ( dst - to.get_start_address() ) * sizeof(unsigned),
+                  from.get_dmi_ptr()
+                      + ( src - from.get_start_address() ) * sizeof(unsigned),
+                  std::size_t( words ) * sizeof(unsigned) );
+
+    unsigned bursts = ( words + config.burst - 1 ) / config.burst;
+    wait( ( from.get_read_latency() + to.get_write_latency() ) * double( bursts ) );
+
+    copied      += words;
+    total_words += words;
+    dmi_words   += words;
+    return true;
+}
+
+bool dma::find_dmi( unsigned first, unsigned last, bool write,
+                    tlm::tlm_dmi& dmi )
+{
+    if( last < first )
+        return false;
+
+    const tlm::tlm_dmi* d = dmi_regions.request( init_socket, first, write );
+    if( !d || last > d->get_end_address() )
+        return false;
+
+    // a copy, the next lookup may reorder the regions
+    dmi = *d;
+    return true;
+}
+
+bool dma::transfer( tlm::tlm_command command, unsigned addr, unsigned* data,
+                    unsigned words, sc_core::sc_time& delay )
+{
+    unsigned length = words * sizeof(unsigned);
+
+    tlm::tlm_generic_payload trans;
+    trans.set_command( command );
+    trans.set_address( addr );
+    trans.set_data_ptr( reinterpret_cast< unsigned char* >( data ) );
+    trans.set_data_length( length );
+    trans.set_streaming_width( length );
+    trans.set_byte_enable_ptr( NULL );
+    trans.set_dmi_allowed( false );
+    trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    init_socket->b_transport( trans, delay );
+    ++transactions;
+
+    if( trans.is_response_error() ) {
+        std::stringstream s;
+        s << trans.get_response_string() << " at address " << addr;
+        SC_REPORT_WARNING( "DMA/Transfer", s.str().c_str() );
+        return false;
+    }
+    return true;
+}
+
+void dma::b_transport( tlm::tlm_generic_payload& trans,
+                       sc_core::sc_time& delay )
+{
+    sc_dt::uint64 addr = trans.get_address();
+    delay += latency;
+
+    if( trans.get_byte_enable_ptr() ) {
+        trans.set_response_status( tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE );
+        return;
+    }
+    if( trans.get_data_length() != sizeof(unsigned)
+        || trans.get_streaming_width() < sizeof(unsigned) ) {
+        trans.set_response_status( tlm::TLM_BURST_ERROR_RESPONSE );
+        return;
+    }
+    if( addr >= registers ) {
+        trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+        return;
+    }
+
+    unsigned* data = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
+    if( trans.is_read() )
+        *data = read_register( addr );
+    else if( trans.is_write() )
+        write_register( addr, *data, delay );
+    trans.set_response_status( tlm::TLM_OK_RESPONSE );
+}
+
+unsigned int dma::transport_dbg( tlm::tlm_generic_payload& trans )
+{
+    // reads only, writes would start chains
+    if( !trans.is_read() || trans.get_byte_enable_ptr() )
+        return 0;
+
+    sc_dt::uint64 addr  = trans.get_address();
+    unsigned      count = trans.get_data_length() / sizeof(unsigned);
+    unsigned*     data  = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
+
+    unsigned i = 0;
+    for( ; i < count && addr + i < registers; ++i )
+        data[i] = read_register( addr + i );
+    return i * sizeof(unsigned);
+}
+
+unsigned dma::read_register( unsigned index ) const
+{
+    switch( index ) {
+    case reg_desc:   return desc;
+    case reg_ctrl:   return ctrl;
+    case reg_status: return status;
+    case reg_words:  return copied;
+    }
+    return 0;
+}
+
+void dma::write_register( unsigned index, unsigned value,
+                          const sc_core::sc_time& delay )
+{
+    switch( index ) {
+    case reg_desc:
+        if( !( status & status_busy ) )
+            desc = value;
+        break;
+
+    case reg_ctrl:
+        ctrl = value & ctrl_irq;
+        if( ( value & ctrl_start ) && !( status & status_busy ) ) {
+            status = status_busy;
+            copied = 0;
+            kick.notify( delay );
+        }
+        break;
+
+    case reg_status:
+        status &= ~( value & ( status_done | status_error ) );
+        break;
+    }
+    update_irq();
+}
+
+void dma::update_irq()
+{
+    irq.write( ( status & status_done ) && ( ctrl & ctrl_irq ) );
+}
+
+void dma::invalidate_direct_mem_ptr( sc_dt::uint64 start, sc_dt::uint64 end )
+{
+    dmi_regions.invalidate( start, end );
+}
+
+void dma::end_of_simulation()
+{
+    std::cout << name() << ": " << chains << " chains, " << descriptors
+              << " descriptors, " << total_words << " words copied ("
+              << dmi_words << " through DMI), " << transactions
+              << " transactions, busy " << busy;
+    if( busy > sc_core::SC_ZERO_TIME )
+        std::cout << " (" << total_words * sizeof(unsigned) / busy.to_seconds() / 1e6
+                  << " MB/s)";
+    std::cout << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
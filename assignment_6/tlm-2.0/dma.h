@@ -0,0 +1,154 @@
+#ifndef DMA_H_INCLUDED_
+#define DMA_H_INCLUDED_
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+
+#include "dmi_cache.h"
+
+#include <string>
+#include <vector>
+
+// Configuration of a DMA controller, from a list of 'key=value'
+// settings (see settings.h); sizes are in words, like addresses (see
+// ram.h):
+//
+//   burst=<n>    words per data transaction (default: 16)
+//   depth=<n>    data transactions in flight (default: 4)
+//   dmi=<b>      copy with memcpy where source and destination grant
+//                DMI, 0 or 1 (default: 1)
+//   latency=<ns> register access time (default: 1)
+struct dma_config
+{
+    dma_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned burst;
+    unsigned depth;
+    bool     dmi;
+    double   latency;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// DMA controller copying blocks of words between targets
+//
+// The registers are words on target_socket, at these word addresses:
+//
+//   0 DESC    address of the first descriptor
+//   1 CTRL    bit 0: write 1 to start the chain at DESC (ignored
+//             while busy); bit 1: enable irq
+//   2 STATUS  bit 0: busy; bit 1: done, bit 2: error, both cleared
+//             by writing 1 to them; irq is high while done is set
+//             and irq enabled
+//   3 WORDS   words copied by the last chain
+//
+// A descriptor is four words in memory: source, destination, number
+// of words and the address of the next descriptor, end_of_chain ends
+// the chain.  Descriptors are read over init_socket.  Registers only
+// take single-word accesses without byte enables.
+//
+// The words of a descriptor are copied in bursts of up to 'burst'
+// words, each read into a buffer and written out again by one of
+// 'depth' worker processes, so up to 'depth' bursts are in flight at
+// once (with overlapping source and destination, the result is as
+// undefined as in hardware).  Where DMI covers both the source and
+// the destination block, the block is copied with memcpy instead,
+// taking the DMI read and write latencies per burst.  A failing
+// transaction sets the error bit and ends the chain.
+struct dma
+: public sc_core::sc_module
+{
+    typedef dma                this_type;
+    typedef sc_core::sc_module base_type;
+
+    enum register_index { reg_desc, reg_ctrl, reg_status, reg_words, registers };
+
+    enum ctrl_bits   { ctrl_start = 1, ctrl_irq = 2 };
+    enum status_bits { status_busy = 1, status_done = 2, status_error = 4 };
+
+    static const unsigned end_of_chain = ~0u;
+
+    tlm_utils::simple_target_socket<this_type>    target_socket;
+    tlm_utils::simple_initiator_socket<this_type> init_socket;
+
+    // completion interrupt, level triggered
+    sc_core::sc_out<bool> irq;
+
+    SC_HAS_PROCESS(this_type);
+    dma( sc_core::sc_module_name, const dma_config& config );
+
+private:
+    // the descriptor chain, started by CTRL
+    void run();
+    // copies the bursts of the current descriptor
+    void worker();
+
+    // copies 'words' from 'src' to 'dst' with memcpy, false if DMI
+    // does not cover both blocks
+    bool copy_dmi( unsigned src, unsigned dst, unsigned words );
+    // DMI region covering [first,last], requested if not known yet
+    bool find_dmi( unsigned first, unsigned last, bool write,
+                   tlm::tlm_dmi& dmi );
+
+    // single transaction of init_socket, annotated to 'delay'
+    bool transfer( tlm::tlm_command command, unsigned addr, unsigned* data,
+                   unsigned words, sc_core::sc_time& delay );
+
+    // registers, on target_socket
+    void b_transport( tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay );
+    unsigned int transport_dbg( tlm::tlm_generic_payload& trans );
+
+    unsigned read_register( unsigned index ) const;
+    void     write_register( unsigned index, unsigned value,
+                             const sc_core::sc_time& delay );
+    // irq follows the done bit, if enabled
+    void     update_irq();
+
+    void invalidate_direct_mem_ptr( sc_dt::uint64 start, sc_dt::uint64 end );
+
+    virtual void end_of_simulation();
+
+    dma_config       config;
+    sc_core::sc_time latency;
+
+    // registers
+    unsigned desc;
+    unsigned ctrl;
+    unsigned status;
+    unsigned copied;
+    sc_core::sc_event kick;
+
+    // the descriptor in progress: bursts are handed out from 'next',
+    // 'finished' words are done
+    unsigned          src;
+    unsigned          dst;
+    unsigned          words;
+    unsigned          next;
+    unsigned          finished;
+    bool              failed;
+    sc_core::sc_event work;
+    sc_core::sc_event burst_done;
+
+    dmi_cache dmi_regions;
+
+    // statistics
+    unsigned long      chains;
+    unsigned long      descriptors;
+    unsigned long      transactions;
+    unsigned long long total_words;
+    unsigned long long dmi_words;
+    sc_core::sc_time   busy;
+};
+
+#endif // DMA_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,70 @@
+#ifndef DMI_CACHE_H_INCLUDED_
+#define DMI_CACHE_H_INCLUDED_
+
+#include <tlm.h>
+
+#include <algorithm> // std::swap
+#include <vector>
+
+// the DMI regions granted to an initiator, word addressed (see ram.h).
+// Lookups move the region found to the front, there may be many of
+// them with page-sized DMI regions.
+struct dmi_cache {
+    // the region covering [first,last] that allows reading (or writing),
+    // NULL if none; valid until the next call
+    const tlm::tlm_dmi* find( sc_dt::uint64 first, sc_dt::uint64 last,
+                              bool write )
+    {
+        for( unsigned i = 0; i < regions.size(); ++i ) {
+            const tlm::tlm_dmi& dmi = regions[i];
+            if( first < dmi.get_start_address() || last > dmi.get_end_address()
+                || !( write ? dmi.is_write_allowed() : dmi.is_read_allowed() ) )
+                continue;
+
+            if( i )
+                std::swap( regions[0], regions[i] );
+            return &regions[0];
+        }
+        return NULL;
+    }
+
+    // the region around addr, requested through 'socket' if not known
+    // yet; NULL if the target grants none allowing reading (or writing)
+    template< typename Socket >
+    const tlm::tlm_dmi* request( Socket& socket, sc_dt::uint64 addr,
+                                 bool write )
+    {
+        if( const tlm::tlm_dmi* known = find( addr, addr, write ) )
+            return known;
+
+        tlm::tlm_generic_payload trans;
+        trans.set_command( write ? tlm::TLM_WRITE_COMMAND
+                                 : tlm::TLM_READ_COMMAND );
+        trans.set_address( addr );
+
+        tlm::tlm_dmi dmi;
+        if( !socket->get_direct_mem_ptr( trans, dmi ) )
+            return NULL;
+        regions.push_back( dmi );
+        return find( addr, addr, write );
+    }
+
+    // drops every region overlapping [start,end]
+    void invalidate( sc_dt::uint64 start, sc_dt::uint64 end )
+    {
+        std::vector<tlm::tlm_dmi>::iterator it = regions.begin();
+        while( it != regions.end() ) {
+            if( it->get_start_address() <= end && start <= it->get_end_address() )
+                it = regions.erase( it );
+            else
+                ++it;
+        }
+    }
+
+private:
+    std::vector<tlm::tlm_dmi> regions;
+};
+
+#endif // DMI_CACHE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
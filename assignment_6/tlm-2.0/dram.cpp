@@ -0,0 +1,370 @@
+
+#include "dram.h"
+#include "payload_pool.h"
+#include "settings.h"
+#include "tracer.h"
+
+#include <algorithm> // std::max, std::min
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+dram_config::dram_config()
+: banks( 8 )
+, row( 512 )
+, policy( open )
+, tRCD( 14 )
+, tCL( 14 )
+, tRP( 14 )
+, tRAS( 33 )
+, tREFI( 7800 )
+, tRFC( 350 )
+, transfer( 1 )
+, queue( 16 )
+{}
+
+bool dram_config::parse( const char* spec )
+{
+    return parse_settings( spec, "DRAM",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool dram_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "policy" ) {
+        if( value == "open" )        policy = open;
+        else if( value == "closed" ) policy = closed;
+        else return false;
+        return true;
+    } else if( key == "banks" ) {
+        ok = ( in >> banks ) && banks > 0;
+    } else if( key == "row" ) {
+        ok = ( in >> row ) && row > 0;
+    } else if( key == "queue" ) {
+        ok = ( in >> queue ) && queue > 0;
+    } else if( key == "tRCD" ) {
+        ok = ( in >> tRCD ) && tRCD >= 0;
+    } else if( key == "tCL" ) {
+        ok = ( in >> tCL ) && tCL >= 0;
+    } else if( key == "tRP" ) {
+        ok = ( in >> tRP ) && tRP >= 0;
+    } else if( key == "tRAS" ) {
+        ok = ( in >> tRAS ) && tRAS >= 0;
+    } else if( key == "tREFI" ) {
+        ok = ( in >> tREFI ) && tREFI > 0;
+    } else if( key == "tRFC" ) {
+        ok = ( in >> tRFC ) && tRFC >= 0;
+    } else if( key == "transfer" ) {
+        ok = ( in >> transfer ) && transfer >= 0;
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+dram::dram( sc_core::sc_module_name name, unsigned size,
+            const dram_config& config, ram_storage* storage )
+: base_type( name, size, sc_core::SC_ZERO_TIME, storage )
+, config( config )
+, tRCD( config.tRCD, sc_core::SC_NS )
+, tCL( config.tCL, sc_core::SC_NS )
+, tRP( config.tRP, sc_core::SC_NS )
+, tRAS( config.tRAS, sc_core::SC_NS )
+, tREFI( config.tREFI, sc_core::SC_NS )
+, tRFC( config.tRFC, sc_core::SC_NS )
+, transfer( config.transfer, sc_core::SC_NS )
+, queue()
+, blocked()
+, banks( config.banks )
+, bus_free()
+, next_refresh( tREFI )
+, refreshes()
+, queued()
+, dequeued()
+, responses( "responses" )
+, response_open( false )
+, response_done()
+, stats()
+{
+    dmi_enabled = false;
+
+    SC_THREAD( schedule );
+    SC_THREAD( respond );
+}
+
+void dram::b_transport( tlm::tlm_generic_payload& trans,
+                        sc_core::sc_time& delay )
+{
+    stats_scope scope( target_stats, trans, delay );
+    trace_scope hop( *this, "service", trans, delay );
+
+    // the scheduler works in kernel time
+    wait( delay );
+    delay = sc_core::SC_ZERO_TIME;
+
+    unsigned words = access( trans );
+    if( !words )
+        return;
+
+    while( queue.size() >= config.queue )
+        wait( dequeued );
+
+    sc_core::sc_event done;
+    enqueue( make_request( trans, words, sc_core::sc_time_stamp(), &done ) );
+    wait( done );
+
+    trans.set_dmi_allowed( false );
+}
+
+tlm::tlm_sync_enum
+dram::nb_transport_fw( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
+                       sc_core::sc_time& delay )
+{
+    if( phase == tlm::END_RESP ) {
+        response_open = false;
+        response_done.notify( delay );
+        return tlm::TLM_COMPLETED;
+    }
+
+    if( phase != tlm::BEGIN_REQ ) {
+        SC_REPORT_ERROR( "DRAM/Protocol", "unexpected phase" );
+        return tlm::TLM_COMPLETED;
+    }
+
+    // errors complete right away, like a ram
+    unsigned words = access( trans );
+    if( !words )
+        return tlm::TLM_COMPLETED;
+
+    target_stats.begin( trans, delay );
+    trans.set_dmi_allowed( false );
+
+    request r = make_request( trans, words,
+                              sc_core::sc_time_stamp() + delay, NULL );
+    if( queue.size() >= config.queue ) {
+        // END_REQ once there is room
+        blocked.push_back( r );
+        return tlm::TLM_ACCEPTED;
+    }
+
+    enqueue( r );
+    phase = tlm::END_REQ;
+    return tlm::TLM_UPDATED;
+}
+
+dram::request dram::make_request( tlm::tlm_generic_payload& trans,
+                                  unsigned words,
+                                  const sc_core::sc_time& arrival,
+                                  sc_core::sc_event* done )
+{
+    // consecutive rows in consecutive banks
+    unsigned row = trans.get_address() / config.row;
+
+    request r;
+    r.trans   = &trans;
+    r.bank    = row % config.banks;
+    r.row     = row / config.banks;
+    r.words   = words;
+    r.arrival = arrival;
+    r.done    = done;
+    r.stats   = &stats[ payload_pool::owner_of( trans ) ];
+    return r;
+}
+
+void dram::enqueue( const request& r )
+{
+    queue.push_back( r );
+    target_stats.queue( queue.size() );
+    queued.notify();
+}
+
+void dram::admit()
+{
+    while( !blocked.empty() && queue.size() < config.queue ) {
+        request r = blocked.front();
+        blocked.pop_front();
+        enqueue( r );
+
+        tlm::tlm_phase   phase = tlm::END_REQ;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        target_socket->nb_transport_bw( *r.trans, phase, delay );
+    }
+}
+
+void dram::schedule()
+{
+    while( true ) {
+        sc_core::sc_time now = sc_core::sc_time_stamp();
+        if( now >= next_refresh )
+            refresh();
+
+        // first ready (row hits), first come first served
+        std::deque<request>::iterator pick = queue.end();
+        sc_core::sc_time              wake = next_refresh;
+        for( std::deque<request>::iterator it = queue.begin();
+             it != queue.end(); ++it ) {
+            const bank_state& b = banks[ it->bank ];
+            sc_core::sc_time ready = std::max( it->arrival, b.ready );
+            if( ready > now ) {
+                wake = std::min( wake, ready );
+                continue;
+            }
+            if( b.open && b.row == it->row ) {
+                pick = it;
+                break;
+            }
+            if( pick == queue.end() )
+                pick = it;
+        }
+
+        if( pick == queue.end() ) {
+            if( queue.empty() )
+                wait( queued );
+            else
+                wait( wake - now, queued );
+            continue;
+        }
+
+        request r = *pick;
+        queue.erase( pick );
+        dequeued.notify();
+        admit();
+
+        sc_core::sc_time done = issue( r ) - now;
+        if( r.done )
+            r.done->notify( done );
+        else
+            responses.notify( *r.trans, done );
+    }
+}
+
+sc_core::sc_time dram::issue( const request& r )
+{
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    bank_state&      b   = banks[ r.bank ];
+    initiator_stats& s   = *r.stats;
+
+    sc_core::sc_time column = now;
+    if( b.open && b.row == r.row ) {
+        ++s.hits;
+    } else {
+        sc_core::sc_time activate = now;
+        if( b.open ) {
+            ++s.conflicts;
+            activate = std::max( now, b.ras ) + tRP;
+        } else {
+            ++s.misses;
+        }
+        b.open = true;
+        b.row  = r.row;
+        b.ras  = activate + tRAS;
+        column = activate + tRCD;
+    }
+
+    sc_core::sc_time burst = transfer * r.words;
+    sc_core::sc_time data  = std::max( column + tCL, bus_free );
+    bus_free = data + burst;
+    b.ready  = column + burst;
+
+    if( config.policy == dram_config::closed ) {
+        b.open  = false;
+        b.ready = std::max( bus_free, b.ras ) + tRP;
+    }
+
+    sc_core::sc_time latency = bus_free - r.arrival;
+    std::size_t      ns      = std::size_t( latency.to_seconds() * 1e9 + .5 );
+    if( ns >= s.histogram.size() )
+        s.histogram.resize( ns + 1 );
+    ++s.histogram[ns];
+    ++s.requests;
+    s.latency += latency;
+
+    return bus_free;
+}
+
+void dram::refresh()
+{
+    // refreshes due while idle delay nothing, the last one may
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    while( next_refresh + tREFI <= now ) {
+        next_refresh += tREFI;
+        ++refreshes;
+    }
+
+    // all banks precharged first
+    sc_core::sc_time start = next_refresh;
+    for( unsigned i = 0; i < banks.size(); ++i ) {
+        const bank_state& b = banks[i];
+        start = std::max( start, b.open ? std::max( b.ready, b.ras ) + tRP
+                                        : b.ready );
+    }
+
+    for( unsigned i = 0; i < banks.size(); ++i ) {
+        banks[i].open  = false;
+        banks[i].ready = std::max( banks[i].ready, start + tRFC );
+    }
+    ++refreshes;
+    next_refresh += tREFI;
+}
+
+void dram::respond()
+{
+    while( true ) {
+        wait( responses.get_event() );
+
+        tlm::tlm_generic_payload* trans;
+        while( ( trans = responses.get_next_transaction() ) ) {
+            // one response in flight at a time
+            while( response_open )
+                wait( response_done );
+
+            target_stats.end( sc_core::SC_ZERO_TIME );
+
+            tlm::tlm_phase   phase = tlm::BEGIN_RESP;
+            sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+            if( target_socket->nb_transport_bw( *trans, phase, delay )
+                == tlm::TLM_ACCEPTED )
+                response_open = true;
+        }
+    }
+}
+
+void dram::end_of_simulation()
+{
+    base_type::end_of_simulation();
+
+    std::map< const sc_core::sc_object*, initiator_stats >::const_iterator it;
+    for( it = stats.begin(); it != stats.end(); ++it ) {
+        const initiator_stats& s = it->second;
+        if( !s.requests )
+            continue;
+
+        // 99th percentile, by the ns
+        std::size_t tail = 0;
+        for( unsigned long seen = 0; tail < s.histogram.size(); ++tail ) {
+            seen += s.histogram[tail];
+            if( 100 * seen >= 99 * s.requests )
+                break;
+        }
+
+        std::cout << name() << " initiator "
+                  << ( it->first ? it->first->name() : "(other)" ) << ": "
+                  << s.requests << " requests, "
+                  << s.hits << "/" << s.misses << "/" << s.conflicts
+                  << " row hits/misses/conflicts (hit rate "
+                  << 100. * s.hits / s.requests << "%), latency avg "
+                  << s.latency / double( s.requests )
+                  << ", p99 " << tail << " ns"
+                  << ", max " << s.histogram.size() - 1 << " ns" << std::endl;
+    }
+    std::cout << name() << ": " << refreshes << " refreshes, "
+              << ( config.policy == dram_config::open ? "open" : "closed" )
+              << " row policy" << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,172 @@
+#ifndef DRAM_H_INCLUDED_
+#define DRAM_H_INCLUDED_
+
+#include "ram.h"
+
+#include <tlm_utils/peq_with_get.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// Configuration of a dram, from a list of 'key=value' settings (see
+// settings.h); times in ns:
+//
+//   banks=<n>     number of banks (default: 8)
+//   row=<n>       words per row (default: 512)
+//   policy=<p>    open (rows stay open for later hits) or closed
+//                 (precharge after every access) (default: open)
+//   tRCD=<ns>     activate to column command (default: 14)
+//   tCL=<ns>      column command to data (default: 14)
+//   tRP=<ns>      precharge to activate (default: 14)
+//   tRAS=<ns>     activate to precharge (default: 33)
+//   tREFI=<ns>    refresh interval (default: 7800)
+//   tRFC=<ns>     refresh time (default: 350)
+//   transfer=<ns> data bus time per word (default: 1)
+//   queue=<n>     requests the controller holds (default: 16)
+struct dram_config
+{
+    enum policy_type { open, closed };
+
+    dram_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned    banks;
+    unsigned    row;
+    policy_type policy;
+    double      tRCD;
+    double      tCL;
+    double      tRP;
+    double      tRAS;
+    double      tREFI;
+    double      tRFC;
+    double      transfer;
+    unsigned    queue;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// DRAM controller target
+//
+// Contents and addressing are those of a ram, the timing is that of
+// DRAM banks behind a request queue.  Consecutive rows go to
+// consecutive banks, i.e. a word address splits into row, bank and
+// column from the top down; bursts are timed by the row of their
+// first word.
+//
+// The scheduler picks the oldest request hitting the open row of an
+// idle bank, or else the oldest request for an idle bank (first
+// ready, first come first served).  A row miss precharges the open
+// row (no earlier than tRAS after its activation) and activates the
+// new one; the data follows tCL after the column command, once the
+// shared data bus is free.  All banks are refreshed every tREFI.
+//
+// Blocking transport waits for the request to be served, so it syncs
+// temporally decoupled initiators.  Non-blocking transport accepts
+// requests right away (END_REQ) while the queue has room and sends
+// BEGIN_RESP when they are served.  Data is read or written when the
+// request arrives, the queue only delays the response.
+//
+// At the end of simulation, row hits and latencies (from arrival to
+// the last data word) are reported per initiator, as named by the
+// payload pool the transactions come from (see payload_pool.h).  DMI
+// is denied, as direct accesses would bypass the controller.
+struct dram
+  : public ram
+{
+    typedef dram this_type;
+    typedef ram  base_type;
+
+    SC_HAS_PROCESS(this_type);
+
+    // takes ownership of 'storage', which has to hold 'size' words
+    dram( sc_core::sc_module_name, unsigned size,
+          const dram_config& config, ram_storage* storage = NULL );
+
+private:
+    struct initiator_stats
+    {
+        initiator_stats()
+        : requests(), hits(), misses(), conflicts(), latency(), histogram() {}
+
+        unsigned long              requests;
+        unsigned long              hits;      // row open
+        unsigned long              misses;    // bank precharged
+        unsigned long              conflicts; // other row open
+        sc_core::sc_time           latency;   // sum
+        std::vector<unsigned long> histogram; // by ns
+    };
+
+    struct request
+    {
+        tlm::tlm_generic_payload* trans;
+        unsigned                  bank;
+        unsigned                  row;
+        unsigned                  words;
+        sc_core::sc_time          arrival;
+        sc_core::sc_event*        done; // blocking transport, else NULL
+        initiator_stats*          stats;
+    };
+
+    struct bank_state
+    {
+        bank_state() : open(), row(), ready(), ras() {}
+
+        bool             open;
+        unsigned         row;
+        sc_core::sc_time ready; // takes the next command
+        sc_core::sc_time ras;   // earliest precharge
+    };
+
+    // tlm_fw_transport_if methods
+    virtual void b_transport( tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    virtual tlm::tlm_sync_enum
+    nb_transport_fw( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
+                     sc_core::sc_time& delay );
+
+    virtual void end_of_simulation();
+
+    request make_request( tlm::tlm_generic_payload& trans, unsigned words,
+                          const sc_core::sc_time& arrival,
+                          sc_core::sc_event* done );
+    void    enqueue( const request& r );
+
+    // requests beyond the queue capacity, once there is room
+    void admit();
+
+    void schedule();
+    void respond();
+
+    void             refresh();
+    sc_core::sc_time issue( const request& r );
+
+    dram_config      config;
+    sc_core::sc_time tRCD, tCL, tRP, tRAS, tREFI, tRFC, transfer;
+
+    std::deque<request>     queue;
+    std::deque<request>     blocked; // not accepted yet
+    std::vector<bank_state> banks;
+    sc_core::sc_time        bus_free;
+    sc_core::sc_time        next_refresh;
+    unsigned long           refreshes;
+
+    sc_core::sc_event queued;
+    sc_core::sc_event dequeued;
+
+    // non-blocking responses
+    tlm_utils::peq_with_get<tlm::tlm_generic_payload> responses;
+    bool                                              response_open;
+    sc_core::sc_event                                 response_done;
+
+    std::map< const sc_core::sc_object*, initiator_stats > stats;
+};
+
+#endif // DRAM_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,25 @@
+#ifndef ISS_DATA_TYPES_H_
+#define ISS_DATA_TYPES_H_
+
+/* The {control,sensor}_data types of the line follower as plain C, for
+ * process_data.cpp built for the target (TARGET_IMPL) */
+
+#define NUMBER_OF_SENSORS 12
+
+/* controller data */
+typedef signed char   movement_type;
+typedef signed char   rotation_type;
+/* sensor data */
+typedef unsigned char sensor_type;
+
+struct sensor_data {
+    movement_type movement;
+    sensor_type   sensor[NUMBER_OF_SENSORS];
+};
+
+struct control_data {
+    movement_type movement;
+    rotation_type rotation;
+};
+
+#endif /* ISS_DATA_TYPES_H_ */
@@ -0,0 +1,11 @@
+#include "workload.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 1000000
+#endif
+
+/* the exit code is the low byte of the checksum, see start.S */
+int main(void)
+{
+    return (int)(controller_workload(ITERATIONS) & 0xff);
+}
@@ -0,0 +1,25 @@
+#include "workload.h"
+#include "process_data.h"
+
+unsigned controller_workload(unsigned iterations)
+{
+    struct sensor_data  sd;
+    struct control_data cd = { 0, 0 };
+    unsigned seed = 1;
+    unsigned sum  = 0;
+    unsigned i, s;
+
+    for (i = 0; i < iterations; ++i) {
+        /* linear congruential generator, the top bits are the better ones */
+        for (s = 0; s < NUMBER_OF_SENSORS; ++s) {
+            seed = seed * 1664525u + 1013904223u;
+            sd.sensor[s] = (sensor_type)(seed >> 24);
+        }
+        sd.movement = cd.movement;
+
+        car_controller_set_control_data(&sd, &cd);
+        sum = sum * 31 + (unsigned char)cd.movement * 256
+                       + (unsigned char)cd.rotation;
+    }
+    return sum;
+}
@@ -0,0 +1,17 @@
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Runs car_controller_set_control_data on 'iterations' pseudo-random
+ * sensor readings, returns a checksum of the control data; the same
+ * on the target and natively */
+unsigned controller_workload(unsigned iterations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKLOAD_H_ */
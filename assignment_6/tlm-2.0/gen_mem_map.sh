@@ -0,0 +1,53 @@
+#!/bin/sh
+#
+# Turns a memory map (see mem_map.txt) into a header with a constexpr
+# table for static_address_map.h
+#
+# usage: gen_mem_map.sh <mem_map> [<name>] > <header>
+#
+# The table is called <name> (default: generated_mem_map) and holds
+# the region of slave i at index i.  Like address_map, start and end
+# addresses are read as hex numbers.
+
+if [ $# -lt 1 ] || [ $# -gt 2 ]; then
+    echo "usage: $0 <mem_map> [<name>]" >&2
+    exit 1
+fi
+
+exec awk -v name="${2:-generated_mem_map}" -v file="$1" '
+function hex( s ) { return s ~ /^0[xX]/ ? s : "0x" s }
+
+/^[ \t]*(#|$)/ { next }
+
+{
+    if( $1 !~ /^[0-9]+$/ || NF < 3 ) {
+        printf "%s:%d: malformed line: %s\n", file, FNR, $0 > "/dev/stderr"
+        failed = 1; exit 1
+    }
+    if( $1 in start ) {
+        printf "%s:%d: slave %d mapped twice\n", file, FNR, $1 > "/dev/stderr"
+        failed = 1; exit 1
+    }
+    start[$1] = hex( $2 ); end[$1] = hex( $3 )
+    if( $1 + 1 > slaves ) slaves = $1 + 1
+}
+
+END {
+    if( failed ) exit 1
+    for( i = 0; i < slaves; ++i )
+        if( !( i in start ) ) {
+            printf "%s: slave %d is not mapped\n", file, i > "/dev/stderr"
+            exit 1
+        }
+
+    guard = toupper( name ) "_H_INCLUDED_"
+    printf "// generated from %s by gen_mem_map.sh - do not edit\n", file
+    printf "#ifndef %s\n#define %s\n\n", guard, guard
+    printf "#include \"static_address_map.h\"\n\n"
+    printf "struct %s {\n", name
+    printf "    static constexpr static_region regions[] = {\n"
+    for( i = 0; i < slaves; ++i )
+        printf "        { %s, %s }, // slave %d\n", start[i], end[i], i
+    printf "    };\n};\n\n"
+    printf "#endif // %s\n", guard
+}' "$1"
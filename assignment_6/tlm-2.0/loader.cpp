@@ -0,0 +1,235 @@
+#include "loader.h"
+
+#include <algorithm> // std::min, std::reverse
+#include <chrono>    // std::chrono::steady_clock
+#include <cstring>   // std::memcmp
+#include <fstream>   // std::ifstream
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+namespace {
+
+void report( const char* id, const std::string& filename, const char* what )
+{
+    std::stringstream s;
+    s << filename << ": " << what;
+    SC_REPORT_ERROR( id, s.str().c_str() );
+}
+
+// unsigned field of 'size' bytes at 'p', in the file's byte order
+sc_dt::uint64 field( const unsigned char* p, unsigned size, bool big )
+{
+    sc_dt::uint64 value = 0;
+    for( unsigned i = 0; i < size; ++i )
+        value |= sc_dt::uint64( p[ big ? size - 1 - i : i ] ) << ( 8 * i );
+    return value;
+}
+
+bool host_is_big_endian()
+{
+    const unsigned one = 1;
+    return !*reinterpret_cast< const unsigned char* >( &one );
+}
+
+} // anonymous namespace
+
+loader::loader( sc_core::sc_module_name /* unused */,
+                tlm::tlm_initiator_socket<>& port, unsigned block )
+: base_type()
+, port( port )
+, block( block ? block : 1 )
+, images()
+, words()
+, transactions()
+{}
+
+void loader::add_binary( const char* filename, sc_dt::uint64 addr )
+{
+    image i = { filename, false, addr };
+    images.push_back( i );
+}
+
+void loader::add_elf( const char* filename )
+{
+    image i = { filename, true, 0 };
+    images.push_back( i );
+}
+
+void loader::add( const char* filename, sc_dt::uint64 addr )
+{
+    char          magic[4] = {};
+    std::ifstream in( filename, std::ios::binary );
+    in.read( magic, sizeof(magic) );
+
+    if( in.gcount() == sizeof(magic) && !std::memcmp( magic, "\177ELF", 4 ) )
+        add_elf( filename );
+    else
+        add_binary( filename, addr );
+}
+
+void loader::start_of_simulation()
+{
+    if( images.empty() )
+        return;
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point started = clock::now();
+
+    for( unsigned i = 0; i < images.size(); ++i ) {
+        if( images[i].elf )
+            load_elf( images[i] );
+        else
+            load_binary( images[i] );
+    }
+
+    std::chrono::duration<double> wall = clock::now() - started;
+    std::cout << name() << ": " << images.size() << " images, "
+              << words << " words in " << transactions
+              << " debug transactions, " << wall.count() << " s"
+              << std::endl;
+}
+
+void loader::load_binary( const image& i )
+{
+    std::ifstream in( i.filename.c_str(), std::ios::binary );
+    if( !in ) {
+        report( "Loader/File", i.filename, "cannot open image" );
+        return;
+    }
+
+    std::vector<unsigned> buffer( block );
+    sc_dt::uint64         addr = i.addr;
+    while( in ) {
+        std::fill( buffer.begin(), buffer.end(), 0 );
+        in.read( reinterpret_cast< char* >( &buffer[0] ),
+                 buffer.size() * sizeof(unsigned) );
+
+        std::size_t n = ( std::size_t( in.gcount() ) + sizeof(unsigned) - 1 )
+                        / sizeof(unsigned);
+        write( addr, &buffer[0], n );
+        addr += n;
+    }
+}
+
+void loader::load_elf( const image& i )
+{
+    std::ifstream in( i.filename.c_str(), std::ios::binary );
+    unsigned char header[64] = {};
+    in.read( reinterpret_cast< char* >( header ), sizeof(header) );
+
+    // the 32 bit header is the shorter one
+    if( in.gcount() < 52 || std::memcmp( header, "\177ELF", 4 )
+        || ( header[4] != 1 && header[4] != 2 )
+        || ( header[5] != 1 && header[5] != 2 ) ) {
+        report( "Loader/ELF", i.filename, "no ELF file" );
+        return;
+    }
+    in.clear();
+
+    const bool wide = header[4] == 2;
+    const bool big  = header[5] == 2;
+    const bool swap = big != host_is_big_endian();
+
+    sc_dt::uint64 phoff     = wide ? field( header + 32, 8, big )
+                                   : field( header + 28, 4, big );
+    unsigned      phentsize = field( header + ( wide ? 54 : 42 ), 2, big );
+    unsigned      phnum     = field( header + ( wide ? 56 : 44 ), 2, big );
+
+    std::vector<unsigned> buffer( block );
+    for( unsigned p = 0; p < phnum; ++p ) {
+        unsigned char ph[56] = {};
+        in.seekg( phoff + sc_dt::uint64( p ) * phentsize );
+        in.read( reinterpret_cast< char* >( ph ), wide ? 56 : 32 );
+        if( !in ) {
+            report( "Loader/ELF", i.filename, "truncated program header" );
+            return;
+        }
+
+        const unsigned PT_LOAD = 1;
+        if( field( ph, 4, big ) != PT_LOAD )
+            continue;
+
+        sc_dt::uint64 offset = wide ? field( ph + 8, 8, big )  : field( ph + 4, 4, big );
+        sc_dt::uint64 paddr  = wide ? field( ph + 24, 8, big ) : field( ph + 12, 4, big );
+        sc_dt::uint64 filesz = wide ? field( ph + 32, 8, big ) : field( ph + 16, 4, big );
+        sc_dt::uint64 memsz  = wide ? field( ph + 40, 8, big ) : field( ph + 20, 4, big );
+
+        if( paddr % sizeof(unsigned) ) {
+            report( "Loader/ELF", i.filename, "segment not word aligned" );
+            return;
+        }
+        sc_dt::uint64 addr = paddr / sizeof(unsigned);
+
+        // the file part, in blocks
+        in.seekg( offset );
+        for( sc_dt::uint64 left = filesz; left; ) {
+            std::size_t bytes = std::min< sc_dt::uint64 >(
+                left, buffer.size() * sizeof(unsigned) );
+            std::fill( buffer.begin(), buffer.end(), 0 );
+            in.read( reinterpret_cast< char* >( &buffer[0] ), bytes );
+            if( !in ) {
+                report( "Loader/ELF", i.filename, "truncated segment" );
+                return;
+            }
+
+            std::size_t n = ( bytes + sizeof(unsigned) - 1 ) / sizeof(unsigned);
+            if( swap )
+                for( std::size_t w = 0; w < n; ++w ) {
+                    unsigned char* b = reinterpret_cast< unsigned char* >( &buffer[w] );
+                    std::reverse( b, b + sizeof(unsigned) );
+                }
+            write( addr, &buffer[0], n );
+            addr += n;
+            left -= bytes;
+        }
+
+        // the rest is cleared, e.g. .bss
+        sc_dt::uint64 file_words = ( filesz + sizeof(unsigned) - 1 ) / sizeof(unsigned);
+        sc_dt::uint64 mem_words  = ( memsz + sizeof(unsigned) - 1 ) / sizeof(unsigned);
+        std::fill( buffer.begin(), buffer.end(), 0 );
+        for( sc_dt::uint64 left = mem_words > file_words ? mem_words - file_words : 0;
+             left; ) {
+            std::size_t n = std::min< sc_dt::uint64 >( left, buffer.size() );
+            write( addr, &buffer[0], n );
+            addr += n;
+            left -= n;
+        }
+    }
+}
+
+void loader::write( sc_dt::uint64 addr, const unsigned* data,
+                    std::size_t count )
+{
+    tlm::tlm_generic_payload trans;
+    while( count ) {
+        unsigned length = std::min< std::size_t >( count, block )
+                          * sizeof(unsigned);
+
+        // targets only read the data of writes
+        trans.set_command( tlm::TLM_WRITE_COMMAND );
+        trans.set_address( addr );
+        trans.set_data_ptr( reinterpret_cast< unsigned char* >(
+                                const_cast< unsigned* >( data ) ) );
+        trans.set_data_length( length );
+        trans.set_streaming_width( length );
+        trans.set_byte_enable_ptr( NULL );
+        trans.set_dmi_allowed( false );
+        trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+        std::size_t done = port->transport_dbg( trans ) / sizeof(unsigned);
+        ++transactions;
+        if( !done ) {
+            std::stringstream s;
+            s << "nothing to load word " << addr << " into";
+            SC_REPORT_ERROR( "Loader/Address", s.str().c_str() );
+            return;
+        }
+
+        addr  += done;
+        data  += done;
+        count -= done;
+        words += done;
+    }
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
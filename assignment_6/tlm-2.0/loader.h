@@ -0,0 +1,69 @@
+#ifndef LOADER_H_INCLUDED_
+#define LOADER_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+
+#include <string>
+#include <vector>
+
+// Preloads memory images in zero simulated time
+//
+// The images are written with debug transport (transport_dbg) through
+// the initiator socket 'port' of an initiator bound to the platform,
+// at the start of simulation, before any process runs.  The writes
+// take the initiator's path (e.g. its cache) and the interconnect's
+// address decoding, but no time and no kernel work.  They go in blocks
+// of up to 'block' words, cut at the ends of the targets' regions.
+//
+// Addresses are word addresses (see ram.h).  A raw binary is copied
+// into consecutive words as it is, its last word padded with zeros.
+// ELF files (32 or 64 bit, either byte order) contribute their
+// loadable segments at their physical addresses, which are byte
+// addresses and have to be word aligned; the words are converted to
+// host byte order, and the part of a segment beyond its file size is
+// cleared.
+struct loader
+: public sc_core::sc_module
+{
+    typedef loader             this_type;
+    typedef sc_core::sc_module base_type;
+
+    loader( sc_core::sc_module_name, tlm::tlm_initiator_socket<>& port,
+            unsigned block = 64 * 1024 );
+
+    // raw binary, starting at 'addr'
+    void add_binary( const char* filename, sc_dt::uint64 addr );
+    // loadable segments of an ELF file
+    void add_elf( const char* filename );
+    // an ELF file if it starts like one, a raw binary at 'addr' otherwise
+    void add( const char* filename, sc_dt::uint64 addr = 0 );
+
+private:
+    struct image
+    {
+        std::string   filename;
+        bool          elf;
+        sc_dt::uint64 addr;
+    };
+
+    virtual void start_of_simulation();
+
+    void load_binary( const image& i );
+    void load_elf( const image& i );
+
+    // writes 'words' words from 'data' to 'addr' on, in blocks
+    void write( sc_dt::uint64 addr, const unsigned* data, std::size_t words );
+
+    tlm::tlm_initiator_socket<>& port;
+    unsigned                     block;
+    std::vector<image>           images;
+
+    // statistics
+    unsigned long long words;
+    unsigned long      transactions;
+};
+
+#endif // LOADER_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
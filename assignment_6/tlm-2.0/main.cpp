@@ -1,19 +1,590 @@
 
 #include <systemc>
+#include <tlm.h>
 
+#include "address_map.h"
+#include "banked_ram.h"
+#include "cache.h"
+#include "checkpoint.h"
+#include "dram.h"
+#include "loader.h"
 #include "master.h"
+#include "mesh.h"
+#include "monitor.h"
+#ifdef WITH_OR1KSIM
+#include "or1ksim_iss.h"
+#endif
+#include "prefetcher.h"
 #include "ram.h"
+#include "replayer.h"
+#include "rv32_iss.h"
+#include "stats.h"
+#include "tracer.h"
+#include "traffic_generator.h"
 
+// platform selection, see the build-* targets in the Makefile
+#ifndef ASSIGNMENT_THREE
+#define ASSIGNMENT_THREE 2
+#endif
 
+#if ASSIGNMENT_THREE == 2
+#include "bus.h"
+#elif ASSIGNMENT_THREE == 3
+#include "crossbar.h"
+#ifdef STATIC_MEM_MAP
+// generated by the build-three-static target, see the Makefile
+#include "mem_map_gen.h"
+#endif
+#elif ASSIGNMENT_THREE == 4
+#include "bus_ca.h"
+#include "master_at.h"
+#endif
 
-int sc_main( int /* argc unused */, char* /* argv unused */[] )
+#include <chrono>   // std::chrono::steady_clock
+#include <cstdlib>  // std::atof, std::atoi, std::strtoull
+#include <cstring>  // std::strcmp
+#include <iostream> // std::cout, std::cerr, std::endl
+#include <sstream>  // std::stringstream
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+static void usage( const char* exe )
+{
+    std::cerr
+      << "usage: " << exe
+      << " [-q <ns>] [-m <file>] [-b <words>] [-o <n>] [-S]\n"
+      << "       [-i <prefix> [-w] [-H]] [-a <policy>,...] [-W <weight>,...]\n"
+      << "       [-r <prefix>] [-t <file>] [-g <traffic>]\n"
+      << "       [-c <prefix> [-e]] [-p <prefix> [-T]] [-C <cache>]\n"
+      << "       [-P <prefetch>] [-B <banks>] [-D <dram>]\n"
+      << "       [-N <mesh>] [-l <image>[@<addr>]] [-x <config>[,<image>]]\n"
+      << "       [-R <elf>] [-k <prefix>@<ns>] [-K <prefix>] [-d] [-s]\n"
+      << "  -q <ns>    global quantum for temporal decoupling\n"
+      << "             (default: 0, sync after every transaction)\n"
+      << "  -m <file>  memory map (default: mem_map.txt)\n"
+      << "  -b <words> words per transaction (default: 1)\n"
+      << "  -o <n>     outstanding transactions of AT masters (default: 4)\n"
+      << "  -S         sparse ram backing store, pages allocated on write\n"
+      << "  -i <prefix> map ram contents from the image <prefix>.<ram>\n"
+      << "  -w         write ram contents back to their images\n"
+      << "             (default: changes are private to the simulation)\n"
+      << "  -H         ask for huge pages for mapped images\n"
+      << "  -a <policy>,...\n"
+      << "             crossbar arbitration per slave: rr, prio or weighted\n"
+      << "             (default: rr, the last one applies to further slaves;\n"
+      << "             first come, first served with -q, see arbiter.h)\n"
+      << "  -W <weight>,...\n"
+      << "             consecutive grants per master under 'weighted'\n"
+      << "             (default: 1)\n"
+      << "  -r <prefix> write traffic counters to <prefix>.csv and .json\n"
+      << "             (DMI accesses are not counted, see -d)\n"
+      << "  -t <file>  trace transactions to <file>, in Chrome trace-event\n"
+      << "             JSON (chrome://tracing, ui.perfetto.dev)\n"
+      << "  -g <traffic> replace the LT masters by traffic generators,\n"
+      << "             configured by a list of settings or @<file>\n"
+      << "             (see traffic_generator.h)\n"
+      << "  -c <prefix> capture the transactions of each LT initiator to\n"
+      << "             <prefix>.<initiator>, DMI is denied while capturing\n"
+      << "  -e         delta-encode captured times and addresses\n"
+      << "  -p <prefix> replay the captures <prefix>.<initiator> in place\n"
+      << "             of the LT initiators, as fast as possible\n"
+      << "  -T         replay with the captured timing\n"
+      << "  -C <cache> put a cache behind each LT initiator, configured by\n"
+      << "             a list of settings or @<file> (see cache.h)\n"
+      << "  -P <prefetch> put a stride prefetcher and write-combining\n"
+      << "             buffer behind each LT initiator (and its cache),\n"
+      << "             configured by a list of settings or @<file>\n"
+      << "             (see prefetcher.h)\n"
+      << "  -B <banks> replace the rams by banked rams, configured by a\n"
+      << "             list of settings or @<file> (see banked_ram.h)\n"
+      << "  -D <dram>  replace the rams by DRAM controllers, configured by\n"
+      << "             a list of settings or @<file> (see dram.h)\n"
+      << "  -N <mesh>  network-on-chip settings or @<file> (see mesh.h)\n"
+      << "  -l <image>[@<addr>]\n"
+      << "             preload an ELF file, or a raw binary at word address\n"
+      << "             <addr> (default: 0), through master0 in zero time;\n"
+      << "             may be repeated (see loader.h)\n"
+      << "  -x <config>[,<image>]\n"
+      << "             run or1ksim with <config> (and <image>) in place of\n"
+      << "             the first LT master (see or1ksim_iss.h, needs\n"
+      << "             OR1KSIM_HOME in the Makefile); the other master\n"
+      << "             keeps to ram1\n"
+      << "  -R <elf>   run the RV32IM ISS from word 0 in place of the\n"
+      << "             first LT master, preloading <elf> (see rv32_iss.h\n"
+      << "             and firmware/); the other master keeps to ram1\n"
+      << "  -k <prefix>@<ns>\n"
+      << "             checkpoint to <prefix> and <prefix>.<ram> at <ns>\n"
+      << "             (see checkpoint.h)\n"
+      << "  -K <prefix> restore the checkpoint <prefix> and resume, with\n"
+      << "             the options of the checkpointed run\n"
+      << "  -d         disable DMI in the masters\n"
+      << "  -s         silent, don't print every access\n";
+}
+
+// backing store selection, see usage()
+struct storage_options
+{
+    bool        sparse;
+    const char* image;
+    bool        shared;
+    bool        huge_pages;
+};
+
+// backing store for the ram 'name' of 'size' words
+static ram_storage* new_storage( const char* name, unsigned size,
+                                 const storage_options& opt )
+{
+    if( opt.image ) {
+        std::string file = std::string( opt.image ) + "." + name;
+        return new mapped_storage( file.c_str(), size,
+                                   opt.shared, opt.huge_pages );
+    }
+    if( opt.sparse )
+        return new sparse_storage( size );
+    return new flat_storage( size );
+}
+
+// the ram 'name' of 'size' words, a DRAM controller or banked if
+// 'drams' or 'banks' is given; lives until the end of the program
+static ram& new_ram( const char* name, unsigned size,
+                     const storage_options& opt, const bank_config* banks,
+                     const dram_config* drams )
+{
+    if( drams )
+        return *new dram( name, size, *drams,
+                          new_storage( name, size, opt ) );
+    if( banks )
+        return *new banked_ram( name, size, *banks,
+                                new_storage( name, size, opt ) );
+    return *new ram( name, size, sc_core::SC_ZERO_TIME,
+                     new_storage( name, size, opt ) );
+}
+
+// LT initiator selection, see usage()
+struct initiator_options
+{
+    const traffic_config* traffic;
+    const char*           capture;
+    bool                  delta;
+    const char*           replay;
+    bool                  timed;
+    const char*           iss;
+    bool                  rv32;
+    const cache_config*   cache;
+    const prefetch_config* prefetch;
+    bool                  use_dmi;
+    bool                  verbose;
+    unsigned              burst;
+};
+
+// LT initiator covering [start,end]: a master, a traffic generator, a
+// replayer or an ISS, possibly behind a capturing monitor, a cache and a
+// prefetcher; lives until the end of the program
+static tlm::tlm_initiator_socket<>&
+new_initiator( const char* name, unsigned start, unsigned end,
+               const initiator_options& opt )
+{
+    tlm::tlm_initiator_socket<>* socket;
+#ifdef WITH_OR1KSIM
+    if( opt.iss ) {
+        std::string config( opt.iss ), image;
+        std::string::size_type comma = config.find( ',' );
+        if( comma != std::string::npos ) {
+            image = config.substr( comma + 1 );
+            config.erase( comma );
+        }
+        socket = &( new or1ksim_iss( name, config.c_str(),
+                        image.empty() ? NULL : image.c_str(),
+                        opt.use_dmi ) )->init_socket;
+    } else
+#endif
+    if( opt.rv32 )
+        socket = &( new rv32_iss( name, 0, opt.use_dmi ) )->init_socket;
+    else if( opt.replay )
+        socket = &( new replayer( name,
+                        ( std::string( opt.replay ) + "." + name ).c_str(),
+                        opt.timed ) )->init_socket;
+    else if( opt.traffic )
+        socket = &( new traffic_generator( name, start, end,
+                                           *opt.traffic ) )->init_socket;
+    else
+        socket = &( new master( name, start, end, opt.use_dmi,
+                                opt.verbose, opt.burst ) )->init_socket;
+
+    if( opt.capture ) {
+        monitor* m = new monitor( ( std::string( name ) + "_monitor" ).c_str(),
+                                  ( std::string( opt.capture ) + "." + name ).c_str(),
+                                  opt.delta );
+        socket->bind( m->target_socket );
+        socket = &m->init_socket;
+    }
+
+    if( opt.cache ) {
+        cache* c = new cache( ( std::string( name ) + "_cache" ).c_str(),
+                              *opt.cache );
+        socket->bind( c->target_socket );
+        socket = &c->init_socket;
+    }
+
+    if( opt.prefetch ) {
+        prefetcher* p = new prefetcher( ( std::string( name ) + "_prefetcher" ).c_str(),
+                                        *opt.prefetch );
+        socket->bind( p->target_socket );
+        socket = &p->init_socket;
+    }
+    return *socket;
+}
+
+#if ASSIGNMENT_THREE == 3
+// applies the -a and -W options to the crossbar's arbiters
+template< unsigned NumMasters, unsigned NumSlaves, typename Map >
+static bool configure( crossbar<NumMasters,NumSlaves,Map>& x,
+                       const char* policies, const char* weights )
 {
-    // TODO: initialisierung und verbindung von ports mit channels
-    // passierte sonst in Testbench, das machen wir jetzt aber hier
-    // master mit ram verbinden
-    // init_socket.bind()
+    std::stringstream p( policies );
+    std::string       item;
+    arbiter::policy   policy = arbiter::round_robin;
+
+    for( unsigned s = 0; s < NumSlaves; ++s ) {
+        if( std::getline( p, item, ',' ) ) {
+            if( item == "rr" )
+                policy = arbiter::round_robin;
+            else if( item == "prio" )
+                policy = arbiter::fixed_priority;
+            else if( item == "weighted" )
+                policy = arbiter::weighted;
+            else
+                return false;
+        }
+        x.set_policy( s, policy );
+    }
+
+    std::stringstream w( weights );
+    for( unsigned m = 0; m < NumMasters && std::getline( w, item, ',' ); ++m )
+        for( unsigned s = 0; s < NumSlaves; ++s )
+            x.set_weight( s, m, std::atoi( item.c_str() ) );
+    return true;
+}
+#endif
+
+int sc_main( int argc, char* argv[] )
+{
+    double      quantum = 0;
+    const char* mem_map = "mem_map.txt";
+    bool        use_dmi = true;
+    bool        verbose = true;
+    unsigned    burst   = 1;
+    unsigned    depth   = 4;
+    storage_options store = { false, NULL, false, false };
+    const char* policies = "rr";
+    const char* weights  = "";
+    mesh_config mesh_settings;
+    std::vector<std::string> images;
+    const char* report   = NULL;
+    traffic_config  traffic;
+    cache_config    caches;
+    prefetch_config prefetches;
+    bank_config     bank_settings;
+    const bank_config* banks = NULL;
+    dram_config     dram_settings;
+    const dram_config* drams = NULL;
+    initiator_options initiators = { NULL, NULL, false, NULL, false, NULL,
+                                     false, NULL, NULL, true, true, 1 };
+    const char*       iss  = NULL;
+    bool              rv32 = false;
+    std::string       save_prefix;
+    double            save_at = 0;
+    const char*       restore = NULL;
+
+    for( int i = 1; i < argc; ++i ) {
+        if( !std::strcmp( argv[i], "-q" ) && i + 1 < argc ) {
+            quantum = std::atof( argv[++i] );
+        } else if( !std::strcmp( argv[i], "-m" ) && i + 1 < argc ) {
+            mem_map = argv[++i];
+        } else if( !std::strcmp( argv[i], "-b" ) && i + 1 < argc ) {
+            burst = std::atoi( argv[++i] );
+        } else if( !std::strcmp( argv[i], "-o" ) && i + 1 < argc ) {
+            depth = std::atoi( argv[++i] );
+        } else if( !std::strcmp( argv[i], "-S" ) ) {
+            store.sparse = true;
+        } else if( !std::strcmp( argv[i], "-i" ) && i + 1 < argc ) {
+            store.image = argv[++i];
+        } else if( !std::strcmp( argv[i], "-w" ) ) {
+            store.shared = true;
+        } else if( !std::strcmp( argv[i], "-H" ) ) {
+            store.huge_pages = true;
+        } else if( !std::strcmp( argv[i], "-a" ) && i + 1 < argc ) {
+            policies = argv[++i];
+        } else if( !std::strcmp( argv[i], "-W" ) && i + 1 < argc ) {
+            weights = argv[++i];
+        } else if( !std::strcmp( argv[i], "-r" ) && i + 1 < argc ) {
+            report = argv[++i];
+        } else if( !std::strcmp( argv[i], "-t" ) && i + 1 < argc ) {
+            if( !tracer::instance().open( argv[++i] ) ) {
+                std::cerr << "cannot open trace file " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if( !std::strcmp( argv[i], "-g" ) && i + 1 < argc ) {
+            if( !traffic.parse( argv[++i] ) )
+                return 1;
+            initiators.traffic = &traffic;
+        } else if( !std::strcmp( argv[i], "-c" ) && i + 1 < argc ) {
+            initiators.capture = argv[++i];
+        } else if( !std::strcmp( argv[i], "-e" ) ) {
+            initiators.delta = true;
+        } else if( !std::strcmp( argv[i], "-p" ) && i + 1 < argc ) {
+            initiators.replay = argv[++i];
+        } else if( !std::strcmp( argv[i], "-T" ) ) {
+            initiators.timed = true;
+        } else if( !std::strcmp( argv[i], "-C" ) && i + 1 < argc ) {
+            if( !caches.parse( argv[++i] ) )
+                return 1;
+            initiators.cache = &caches;
+        } else if( !std::strcmp( argv[i], "-P" ) && i + 1 < argc ) {
+            if( !prefetches.parse( argv[++i] ) )
+                return 1;
+            initiators.prefetch = &prefetches;
+        } else if( !std::strcmp( argv[i], "-B" ) && i + 1 < argc ) {
+            if( !bank_settings.parse( argv[++i] ) )
+                return 1;
+            banks = &bank_settings;
+        } else if( !std::strcmp( argv[i], "-D" ) && i + 1 < argc ) {
+            if( !dram_settings.parse( argv[++i] ) )
+                return 1;
+            drams = &dram_settings;
+        } else if( !std::strcmp( argv[i], "-N" ) && i + 1 < argc ) {
+            if( !mesh_settings.parse( argv[++i] ) )
+                return 1;
+        } else if( !std::strcmp( argv[i], "-l" ) && i + 1 < argc ) {
+            images.push_back( argv[++i] );
+        } else if( !std::strcmp( argv[i], "-x" ) && i + 1 < argc ) {
+#ifdef WITH_OR1KSIM
+            iss = argv[++i];
+#else
+            std::cerr << "built without or1ksim, see OR1KSIM_HOME in the"
+                      << " Makefile" << std::endl;
+            return 1;
+#endif
+        } else if( !std::strcmp( argv[i], "-R" ) && i + 1 < argc ) {
+            images.push_back( argv[++i] );
+            rv32 = true;
+        } else if( !std::strcmp( argv[i], "-d" ) ) {
+            use_dmi = false;
+        } else if( !std::strcmp( argv[i], "-k" ) && i + 1 < argc ) {
+            save_prefix = argv[++i];
+            std::string::size_type at = save_prefix.rfind( '@' );
+            if( at == std::string::npos || at == 0 ) {
+                usage( argv[0] );
+                return 1;
+            }
+            save_at = std::atof( save_prefix.c_str() + at + 1 );
+            save_prefix.erase( at );
+        } else if( !std::strcmp( argv[i], "-K" ) && i + 1 < argc ) {
+            restore = argv[++i];
+        } else if( !std::strcmp( argv[i], "-s" ) ) {
+            verbose = false;
+        } else {
+            usage( argv[0] );
+            return 1;
+        }
+    }
+
+    tlm::tlm_global_quantum::instance().set(
+        sc_core::sc_time( quantum, sc_core::SC_NS ) );
+
+    // only the LT masters, the rams and the arbiters save their state
+    if( ( !save_prefix.empty() || restore )
+        && ( initiators.traffic || initiators.replay || iss || rv32
+             || initiators.cache || initiators.prefetch
+             || ASSIGNMENT_THREE == 4 ) ) {
+        std::cerr << "checkpoints need the LT masters, without caches"
+                  << " and prefetchers (see checkpoint.h)" << std::endl;
+        return 1;
+    }
+    if( restore ) {
+        if( !images.empty() ) {
+            std::cerr << "restored rams are not loaded again" << std::endl;
+            return 1;
+        }
+        if( !checkpoint::instance().load( restore ) )
+            return 1;
+
+        // the rams map their images copy-on-write
+        store.image  = restore;
+        store.shared = false;
+    }
+
+    // the rams cover their region of the memory map
+    address_map map( 2, mem_map );
+    const unsigned size0 = map.get_end_address(0) - map.get_start_address(0) + 1;
+#if ASSIGNMENT_THREE != 1
+    const unsigned size1 = map.get_end_address(1) - map.get_start_address(1) + 1;
+
+    // master0 walks both rams, master1 the upper half of ram0 and the
+    // lower half of ram1; next to an ISS, which keeps its code and
+    // stack in ram0, the other master walks ram1 only
+    const unsigned first  = map.get_start_address(0);
+    const unsigned last   = map.get_end_address(1);
+    const bool     shared = !iss && !rv32;
+    const unsigned first1 = shared ? first + size0 / 2 : map.get_start_address(1);
+    const unsigned last1  = shared ? last - size1 / 2 : last;
+#endif
+
+#if ASSIGNMENT_THREE != 4
+    (void) depth; // no AT masters
+#endif
+#if ASSIGNMENT_THREE != 3
+    (void) policies; // no crossbar
+    (void) weights;
+#endif
+#if ASSIGNMENT_THREE != 5
+    (void) mesh_settings; // no network-on-chip
+#endif
+
+    initiators.use_dmi = use_dmi;
+    initiators.verbose = verbose;
+    initiators.burst   = burst;
+
+    // the ISS, if any, takes the place of the first LT master
+    initiator_options first_lt = initiators;
+    first_lt.iss  = iss;
+    first_lt.rv32 = rv32;
+
+#if ASSIGNMENT_THREE == 1
+    // single master, directly connected to a single ram
+    tlm::tlm_initiator_socket<>& m
+        = new_initiator( "master", 0, size0 - 1, first_lt );
+    ram&   r = new_ram( "ram", size0, store, banks, drams );
+
+    m.bind( r.target_socket );
+
+#elif ASSIGNMENT_THREE == 2
+    // two masters sharing both rams over the bus
+    tlm::tlm_initiator_socket<>& m0
+        = new_initiator( "master0", first, last, first_lt );
+    tlm::tlm_initiator_socket<>& m1
+        = new_initiator( "master1", first1, last1,
+                         initiators );
+    bus    b( "bus", mem_map );
+    ram&   r0 = new_ram( "ram0", size0, store, banks, drams );
+    ram&   r1 = new_ram( "ram1", size1, store, banks, drams );
+
+    m0.bind( b.target_socket );
+    m1.bind( b.target_socket );
+    b.init_socket.bind( r0.target_socket );
+    b.init_socket.bind( r1.target_socket );
+
+#elif ASSIGNMENT_THREE == 4
+    // pipelined AT bus, master1 is served by its LT-to-AT adapter
+    master_at m0( "master0", shared ? first : first1, last, depth, verbose );
+    tlm::tlm_initiator_socket<>& m1
+        = new_initiator( "master1", first1, last1,
+                         first_lt );
+    bus_ca    b( "bus_ca", mem_map );
+    ram&      r0 = new_ram( "ram0", size0, store, banks, drams );
+    ram&      r1 = new_ram( "ram1", size1, store, banks, drams );
+
+    m0.init_socket.bind( b.target_socket );
+    m1.bind( b.target_socket );
+    b.init_socket.bind( r0.target_socket );
+    b.init_socket.bind( r1.target_socket );
+
+#elif ASSIGNMENT_THREE == 3
+    // same platform, but on a crossbar
+    tlm::tlm_initiator_socket<>& m0
+        = new_initiator( "master0", first, last, first_lt );
+    tlm::tlm_initiator_socket<>& m1
+        = new_initiator( "master1", first1, last1,
+                         initiators );
+#ifdef STATIC_MEM_MAP
+    // decoding compiled in, -m only sizes the rams and masters
+    crossbar<2,2,generated_mem_map> x( "crossbar" );
+#else
+    crossbar<2,2> x( "crossbar", mem_map );
+#endif
+    if( !configure( x, policies, weights ) ) {
+        usage( argv[0] );
+        return 1;
+    }
+    ram&   r0 = new_ram( "ram0", size0, store, banks, drams );
+    ram&   r1 = new_ram( "ram1", size1, store, banks, drams );
+
+    m0.bind( x.target_sockets[0] );
+    m1.bind( x.target_sockets[1] );
+    x.init_sockets[0].bind( r0.target_socket );
+    x.init_sockets[1].bind( r1.target_socket );
+
+#elif ASSIGNMENT_THREE == 5
+    // same platform, on a network-on-chip: the masters on the first
+    // row, the rams at the far end
+    tlm::tlm_initiator_socket<>& m0
+        = new_initiator( "master0", first, last, first_lt );
+    tlm::tlm_initiator_socket<>& m1
+        = new_initiator( "master1", first1, last1,
+                         initiators );
+    mesh   n( "mesh", mesh_settings, mem_map );
+    ram&   r0 = new_ram( "ram0", size0, store, banks, drams );
+    ram&   r1 = new_ram( "ram1", size1, store, banks, drams );
+
+    n.place_initiator( 0, 0 );
+    n.place_initiator( 1, 1 % n.nodes() );
+    n.place_target( 0, n.nodes() - 1 );
+    n.place_target( 1, n.nodes() > 1 ? n.nodes() - 2 : 0 );
+
+    m0.bind( n.target_socket );
+    m1.bind( n.target_socket );
+    n.init_socket.bind( r0.target_socket );
+    n.init_socket.bind( r1.target_socket );
+
+#else
+#error "ASSIGNMENT_THREE selects the platform, 1 to 5 (see the Makefile)"
+#endif
+
+    // images go in through the first master's path
+#if ASSIGNMENT_THREE == 1
+    tlm::tlm_initiator_socket<>& boot = m;
+#elif ASSIGNMENT_THREE == 4
+    tlm::tlm_initiator_socket<>& boot = m0.init_socket;
+#else
+    tlm::tlm_initiator_socket<>& boot = m0;
+#endif
+    if( !images.empty() ) {
+        loader* l = new loader( "loader", boot );
+        for( unsigned i = 0; i < images.size(); ++i ) {
+            std::string::size_type at = images[i].rfind( '@' );
+            if( at == std::string::npos )
+                l->add( images[i].c_str() );
+            else
+                l->add( images[i].substr( 0, at ).c_str(),
+                        std::strtoull( images[i].c_str() + at + 1, NULL, 0 ) );
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point started = clock::now();
+
+    if( !save_prefix.empty() ) {
+        sc_core::sc_start( sc_core::sc_time( save_at, sc_core::SC_NS ) );
+        if( !checkpoint::instance().save( save_prefix.c_str() ) )
+            return 1;
+    }
     sc_core::sc_start();
 
+    std::chrono::duration<double> wall = clock::now() - started;
+    tracer::instance().close();
+
+    std::cout << "simulated " << sc_core::sc_time_stamp()
+              << " in " << wall.count() << " s"
+              << " (" << sc_core::sc_delta_count() << " delta cycles,"
+              << " quantum " << tlm::tlm_global_quantum::instance().get()
+              << ")" << std::endl;
+
+    if( report && !write_stats_report( report ) ) {
+        std::cerr << "cannot write the traffic report " << report
+                  << " (counters disabled with NSTATS?)" << std::endl;
+        return 1;
+    }
+
     return 0;
 }
 
@@ -3,90 +3,211 @@
 #include <tlm.h>
 
 #include "master.h"
-#include "utils.h"
+#include "tracer.h"
+
+#include <algorithm> // std::max, std::min
+#include <cstring>   // std::memcpy
 
 master::master( sc_core::sc_module_name /* unused */, 
-                unsigned start_addr, unsigned end_addr )
+                unsigned start_addr, unsigned end_addr,
+                bool use_dmi, bool verbose, unsigned burst )
 : base_type()
 , init_socket( "init_socket" )
 , start( start_addr )
 , end( end_addr )
+, use_dmi( use_dmi )
+, verbose( verbose )
+, burst( burst ? burst : 1 )
+, dmi_regions()
+, pass( writing )
+, position( start_addr )
+, qk()
+, pool( this->burst * sizeof(unsigned), this )
 {
     SC_THREAD( action );
     init_socket.bind( *this );
+    checkpoint::instance().add( name(), *this );
 }
 
 void master::action()
 {
-    // our data storage
-    unsigned data;
-
-
-    // prepare generic payload and delay
-    tlm::tlm_generic_payload trans;
-    trans.set_byte_enable_ptr( NULL );
-    trans.set_byte_enable_length( 0 );
-    trans.set_dmi_allowed( false );
-
-    // set data options
-    trans.set_data_length( sizeof(data) );
-    trans.set_streaming_width( sizeof(data) );
+    // prepare generic payload and delay, the payload comes with
+    // storage for one burst
+    tlm::tlm_generic_payload& trans = *pool.allocate();
+    unsigned* data = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
 
-    // set ptr to our data to payload
-    trans.set_data_ptr( reinterpret_cast< unsigned char* >( &data ) );
+    // a restored master resumes at the time of the checkpoint
+    sc_core::sc_time begin( 10, sc_core::SC_NS );
+    if( checkpoint::instance().restoring() )
+        begin = std::max( begin, checkpoint::instance().time() );
+    wait( begin );
+    qk.reset();
 
-    wait( 10, sc_core::SC_NS );
+    // transaction delay, annotated by the interconnect and target
+    sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
 
     // first, start write commands
     trans.set_command( tlm::TLM_WRITE_COMMAND );
 
-    // transaction delay not used here
-    sc_core::sc_time delay_unused = sc_core::SC_ZERO_TIME;
-
-    for ( unsigned addr = start; addr <= end; addr++ ) {
-        timer t;
+    for ( unsigned addr = position; pass == writing && addr <= end; addr += burst ) {
+        sc_core::sc_time issued = qk.get_current_time();
+        unsigned words = std::min( burst, end - addr + 1 );
 
         // send some random data
-        data = rand();
+        for ( unsigned i = 0; i < words; i++ )
+            data[i] = rand();
 
         // update payload attributes for this transaction
         trans.set_address( addr );
+        trans.set_data_length( words * sizeof(unsigned) );
+        trans.set_streaming_width( words * sizeof(unsigned) );
         trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
 
-        // access the connected target
-        init_socket->b_transport( trans, delay_unused );
+        // access the connected target; once done, a checkpoint
+        // resumes after it
+        transport( trans, delay );
+        position = addr + burst;
+
+        consume( delay, sc_core::SC_ZERO_TIME );
 
-        wait( sc_core::SC_ZERO_TIME );
+        if( verbose )
+            for ( unsigned i = 0; i < words; i++ )
+                std::cout << name()
+                    << " write addr=" << addr + i << ", data=" << data[i]
+                    << " at " << qk.get_current_time()
+                    << " (duration: " << qk.get_current_time() - issued << ")"
+                    << std::endl;
+    }
 
-        std::cout << name()
-            << " write addr=" << addr << ", data=" << data
-            << " at " << sc_core::sc_time_stamp()
-            << " (duration: " << t.get() << ")"
-            << std::endl;
+    if( pass == writing ) {
+        pass     = reading;
+        position = start;
     }
 
     // update payload attributes for read access
     trans.set_command( tlm::TLM_READ_COMMAND );
 
-    for ( unsigned addr = start; addr <= end; addr++ ) {
-        timer t;
+    for ( unsigned addr = position; pass == reading && addr <= end; addr += burst ) {
+        sc_core::sc_time issued = qk.get_current_time();
+        unsigned words = std::min( burst, end - addr + 1 );
 
         // update payload attributes for this transaction
         trans.set_address( addr );
+        trans.set_data_length( words * sizeof(unsigned) );
+        trans.set_streaming_width( words * sizeof(unsigned) );
         trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
 
-        // access the connected target
-        init_socket->b_transport( trans, delay_unused );
+        // access the connected target; once done, a checkpoint
+        // resumes after it
+        transport( trans, delay );
+        position = addr + burst;
 
-        std::cout << name()
-            << " read addr=" << addr << ", data=" << data
-            << " at " << sc_core::sc_time_stamp()
-            << " (duration: " << t.get() << ")"
-            << std::endl;
+        if( verbose )
+            for ( unsigned i = 0; i < words; i++ )
+                std::cout << name()
+                    << " read addr=" << addr + i << ", data=" << data[i]
+                    << " at " << qk.get_current_time() + delay
+                    << " (duration: " << qk.get_current_time() + delay - issued << ")"
+                    << std::endl;
 
-        wait( 1, sc_core::SC_NS );
+        consume( delay, sc_core::sc_time( 1, sc_core::SC_NS ) );
     }
+
+    pass = done;
+
+    // catch up with the local time before the process ends
+    qk.sync();
+    trans.release();
     // end of process
 }
 
+bool master::save_state( state_type& state, const std::string& /* prefix unused */ )
+{
+    state.push_back( pass );
+    state.push_back( position );
+    return true;
+}
+
+bool master::restore_state( const state_type& state )
+{
+    if( state.size() != 2 || state[0] > done
+        || state[1] < start || state[1] > end )
+        return false;
+
+    pass     = pass_type( state[0] );
+    position = unsigned( state[1] );
+    return true;
+}
+
+void master::consume( sc_core::sc_time& delay, const sc_core::sc_time& step )
+{
+    // Without a global quantum, the quantum keeper yields to the
+    // kernel after every access, i.e. this becomes 'wait(delay+step)'.
+    qk.inc( delay + step );
+    delay = sc_core::SC_ZERO_TIME;
+
+    if( qk.need_sync() )
+        qk.sync();
+}
+
+void master::transport( tlm::tlm_generic_payload& trans,
+                        sc_core::sc_time& delay )
+{
+    // from issue to response
+    trace_scope scope( *this, "transaction", trans, delay, true );
+
+    if( use_dmi && dmi_access( trans, delay ) )
+        return;
+
+    trans.set_dmi_allowed( false );
+    init_socket->b_transport( trans, delay );
+
+    // e.g. a burst crossing the end of a slave's region
+    if( trans.is_response_error() )
+        SC_REPORT_WARNING( "Master/Response",
+                           trans.get_response_string().c_str() );
+
+    // the target offers direct access, use it next time
+    if( use_dmi && trans.is_dmi_allowed() )
+        dmi_regions.request( init_socket, trans.get_address(),
+                             trans.is_write() );
+}
+
+bool master::dmi_access( tlm::tlm_generic_payload& trans,
+                         sc_core::sc_time& delay )
+{
+    sc_dt::uint64 addr = trans.get_address();
+    sc_dt::uint64 last = addr + trans.get_data_length() / sizeof(unsigned) - 1;
+
+    // plain bursts only, streams and byte enables go to the target
+    if( trans.get_byte_enable_ptr()
+        || trans.get_streaming_width() < trans.get_data_length()
+        || !( trans.is_read() || trans.is_write() ) )
+        return false;
+
+    const tlm::tlm_dmi* dmi = dmi_regions.find( addr, last, trans.is_write() );
+    if( !dmi )
+        return false;
+
+    // word addressed, see ram.h
+    unsigned char* word = dmi->get_dmi_ptr()
+        + ( addr - dmi->get_start_address() ) * sizeof(unsigned);
+
+    if( trans.is_read() ) {
+        std::memcpy( trans.get_data_ptr(), word, trans.get_data_length() );
+        delay += dmi->get_read_latency();
+    } else {
+        std::memcpy( word, trans.get_data_ptr(), trans.get_data_length() );
+        delay += dmi->get_write_latency();
+    }
+    trans.set_response_status( tlm::TLM_OK_RESPONSE );
+    return true;
+}
+
+void master::invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                        sc_dt::uint64 end )
+{
+    dmi_regions.invalidate( start, end );
+}
+
 /* vim: set ts=4 sw=4 tw=72 et :*/
@@ -3,17 +3,29 @@
 
 #include <systemc>
 #include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
 
+#include "checkpoint.h"
+#include "dmi_cache.h"
+#include "payload_pool.h"
+
+
+// Checkpoints save the progress through the two passes, the access
+// in flight at the checkpoint is issued again after restoring.  The
+// random data written afterwards differs (rand() is not saved).
 struct master
 : public sc_core::sc_module
 , protected tlm::tlm_bw_transport_if<> 
+, protected checkpointable
 {
     typedef master             this_type;
     typedef sc_core::sc_module base_type;
 
     SC_HAS_PROCESS(this_type);
     master( sc_core::sc_module_name,
-            unsigned start_addr, unsigned end_addr );
+            unsigned start_addr, unsigned end_addr,
+            bool use_dmi = true, bool verbose = true,
+            unsigned burst = 1 );
 
     // process implementation
     void action();
@@ -22,6 +34,18 @@ struct master
 
 private: // implementation details
 
+    // advance the local time by the annotated delay plus 'step',
+    // synchronise when the quantum is used up
+    void consume( sc_core::sc_time& delay, const sc_core::sc_time& step );
+
+    // access to the target, through DMI if possible
+    void transport( tlm::tlm_generic_payload& trans,
+                    sc_core::sc_time& delay );
+
+    // Direct Memory Interface
+    bool dmi_access( tlm::tlm_generic_payload& trans,
+                     sc_core::sc_time& delay );
+
     // tlm_bw_transport_if methods (neccessary for non-blocking or
     // debug interfaces, but not used here)
     virtual tlm::tlm_sync_enum
@@ -29,13 +53,34 @@ private: // implementation details
                      sc_core::sc_time& )
     { return tlm::TLM_COMPLETED; }
 
-    virtual void invalidate_direct_mem_ptr( sc_dt::uint64,
-                                            sc_dt::uint64 )
-    { }
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    // checkpointable methods
+    virtual bool save_state( state_type& state, const std::string& prefix );
+    virtual bool restore_state( const state_type& state );
 
     // member variables
     unsigned start;
     unsigned end;
+
+    bool use_dmi;
+    bool verbose;
+    // words per transaction
+    unsigned burst;
+    // DMI regions granted so far
+    dmi_cache dmi_regions;
+
+    // progress: the pass, and the address of its next access
+    enum pass_type { writing, reading, done };
+    pass_type pass;
+    unsigned  position;
+
+    // local time for temporal decoupling
+    tlm_utils::tlm_quantumkeeper qk;
+
+    // payloads (and data buffers) for our transactions
+    payload_pool pool;
 }; // master
 
 #endif // MASTER_H_INCLUDED_
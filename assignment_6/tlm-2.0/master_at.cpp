@@ -0,0 +1,133 @@
+
+#include <systemc>
+#include <tlm.h>
+
+#include "master_at.h"
+
+master_at::master_at( sc_core::sc_module_name /* unused */,
+                      unsigned start_addr, unsigned end_addr,
+                      unsigned depth, bool verbose )
+: base_type()
+, init_socket( "init_socket" )
+, start( start_addr )
+, end( end_addr )
+, depth( depth ? depth : 1 )
+, verbose( verbose )
+, outstanding( 0 )
+, open_request( NULL )
+, pool( sizeof(unsigned), this )
+{
+    SC_THREAD( action );
+    init_socket.bind( *this );
+}
+
+void master_at::action()
+{
+    wait( 10, sc_core::SC_NS );
+
+    // first, start write commands
+    for ( unsigned addr = start; addr <= end; addr++ )
+        issue( tlm::TLM_WRITE_COMMAND, addr );
+
+    for ( unsigned addr = start; addr <= end; addr++ )
+        issue( tlm::TLM_READ_COMMAND, addr );
+
+    // wait for the last responses
+    while( outstanding )
+        wait( response_done );
+    // end of process
+}
+
+void master_at::issue( tlm::tlm_command cmd, unsigned addr )
+{
+    while( outstanding == depth )
+        wait( response_done );
+
+    // the payload lives until its response arrives, the pool hands it
+    // out with a one-word buffer and all other attributes reset
+    tlm::tlm_generic_payload* trans = pool.allocate();
+    trans->set_command( cmd );
+    trans->set_address( addr );
+
+    unsigned* data = reinterpret_cast< unsigned* >( trans->get_data_ptr() );
+    *data = ( cmd == tlm::TLM_WRITE_COMMAND ) ? rand() : 0;
+
+    tlm::tlm_phase   phase = tlm::BEGIN_REQ;
+    sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+
+    ++outstanding;
+    open_request = trans;
+
+    switch( init_socket->nb_transport_fw( *trans, phase, delay ) ) {
+        case tlm::TLM_ACCEPTED:
+            break;
+        case tlm::TLM_UPDATED:
+            open_request = NULL;
+            if( phase == tlm::BEGIN_RESP ) {
+                // complete the response phase ourselves
+                sc_core::sc_time response = delay;
+                phase = tlm::END_RESP;
+                init_socket->nb_transport_fw( *trans, phase, delay );
+                finish( *trans, response );
+            }
+            break;
+        case tlm::TLM_COMPLETED:
+            open_request = NULL;
+            finish( *trans, delay );
+            break;
+    }
+
+    // only one request phase at a time
+    while( open_request )
+        wait( end_request );
+}
+
+void master_at::finish( tlm::tlm_generic_payload& trans,
+                        const sc_core::sc_time& delay )
+{
+    unsigned* data = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
+
+    if( trans.is_response_error() )
+        SC_REPORT_WARNING( "Master/Response",
+                           trans.get_response_string().c_str() );
+
+    if( verbose )
+        std::cout << name()
+            << ( trans.is_write() ? " write" : " read" )
+            << " addr=" << trans.get_address() << ", data=" << *data
+            << " at " << sc_core::sc_time_stamp() + delay
+            << " (outstanding: " << outstanding << ")"
+            << std::endl;
+
+    trans.release();
+
+    --outstanding;
+    response_done.notify( delay );
+}
+
+void master_at::end_of_simulation()
+{
+    std::cout << name() << " payload pool: "
+              << pool.allocated() << " transactions, "
+              << pool.created() << " payloads created"
+              << std::endl;
+}
+
+tlm::tlm_sync_enum
+master_at::nb_transport_bw( tlm::tlm_generic_payload& trans,
+                            tlm::tlm_phase& phase, sc_core::sc_time& delay )
+{
+    // END_REQ, or BEGIN_RESP implying it
+    if( &trans == open_request ) {
+        open_request = NULL;
+        end_request.notify( delay );
+    }
+
+    if( phase == tlm::BEGIN_RESP ) {
+        finish( trans, delay );
+        return tlm::TLM_COMPLETED;
+    }
+    return tlm::TLM_ACCEPTED;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
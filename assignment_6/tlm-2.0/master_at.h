@@ -0,0 +1,67 @@
+#ifndef MASTER_AT_H_INCLUDED_
+#define MASTER_AT_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+
+#include "payload_pool.h"
+
+// Approximately-timed master
+//
+// Same access pattern as 'master', but issues its accesses with
+// nb_transport and keeps up to 'depth' of them outstanding.
+struct master_at
+: public sc_core::sc_module
+, protected tlm::tlm_bw_transport_if<>
+{
+    typedef master_at          this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+    master_at( sc_core::sc_module_name,
+               unsigned start_addr, unsigned end_addr,
+               unsigned depth = 4, bool verbose = true );
+
+    // process implementation
+    void action();
+
+    tlm::tlm_initiator_socket<> init_socket;
+
+private: // implementation details
+
+    // start a single access, blocks while 'depth' are outstanding
+    void issue( tlm::tlm_command cmd, unsigned addr );
+    // response received
+    void finish( tlm::tlm_generic_payload& trans,
+                 const sc_core::sc_time& delay );
+
+    virtual void end_of_simulation();
+
+    // tlm_bw_transport_if methods
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
+                     sc_core::sc_time& delay );
+
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64,
+                                            sc_dt::uint64 )
+    { }
+
+    // member variables
+    unsigned start;
+    unsigned end;
+    unsigned depth;
+    bool     verbose;
+
+    unsigned                  outstanding;
+    // last request, until END_REQ is received
+    tlm::tlm_generic_payload* open_request;
+    sc_core::sc_event         end_request;
+    sc_core::sc_event         response_done;
+
+    // payloads in flight
+    payload_pool pool;
+}; // master_at
+
+#endif // MASTER_AT_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,337 @@
+
+#include <systemc>
+#include <tlm.h>
+
+#include "debug_transport.h"
+#include "mesh.h"
+#include "settings.h"
+#include "tracer.h"
+
+#include <iostream> // std::cout, std::endl
+#include <sstream>  // std::stringstream
+
+// not placed explicitly, see end_of_elaboration
+static const unsigned unplaced = unsigned( -1 );
+
+mesh_config::mesh_config()
+: width( 2 )
+, height( 2 )
+, vcs( 2 )
+, depth( 4 )
+, flit( 2 )
+, cycle( 1 )
+, link( 1 )
+, router( 2 )
+{}
+
+bool mesh_config::parse( const char* spec )
+{
+    return parse_settings( spec, "Mesh",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool mesh_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "width" ) {
+        ok = ( in >> width ) && width > 0;
+    } else if( key == "height" ) {
+        ok = ( in >> height ) && height > 0;
+    } else if( key == "vcs" ) {
+        ok = ( in >> vcs ) && vcs > 0;
+    } else if( key == "depth" ) {
+        ok = ( in >> depth ) && depth > 0;
+    } else if( key == "flit" ) {
+        ok = ( in >> flit ) && flit > 0;
+    } else if( key == "cycle" ) {
+        ok = ( in >> cycle ) && cycle > 0;
+    } else if( key == "link" ) {
+        ok = bool( in >> link );
+    } else if( key == "router" ) {
+        ok = bool( in >> router );
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+mesh::mesh( sc_core::sc_module_name /* unused */, const mesh_config& config,
+            const char* mem_map )
+: base_type()
+, init_socket("init_socket")
+, target_socket("target_socket")
+, config( config )
+, mem_map( mem_map )
+, cycle( config.cycle, sc_core::SC_NS )
+, cycles_per_flit()
+, injection( nodes() )
+, links( nodes() * ports )
+, initiator_node()
+, target_node()
+, decoded()
+, packets()
+, hops()
+, latency()
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
+
+    for( unsigned i = 0; i < injection.size(); ++i )
+        injection[i].vcs.resize( config.vcs );
+    for( unsigned i = 0; i < links.size(); ++i )
+        links[i].vcs.resize( config.vcs );
+
+    // a credit returns after a flit crossed the link and the router,
+    // and crossed back
+    unsigned round_trip = 2 * config.link + config.router;
+    cycles_per_flit = ( round_trip + config.depth - 1 ) / config.depth;
+    if( cycles_per_flit < 1 )
+        cycles_per_flit = 1;
+}
+
+void mesh::place_initiator( unsigned index, unsigned node )
+{
+    if( node >= nodes() )
+        SC_REPORT_ERROR( "Mesh/Place", "initiator beyond the last node" );
+    if( index >= initiator_node.size() )
+        initiator_node.resize( index + 1, unplaced );
+    initiator_node[index] = node;
+}
+
+void mesh::place_target( unsigned index, unsigned node )
+{
+    if( node >= nodes() )
+        SC_REPORT_ERROR( "Mesh/Place", "target beyond the last node" );
+    if( index >= target_node.size() )
+        target_node.resize( index + 1, unplaced );
+    target_node[index] = node;
+}
+
+void mesh::b_transport( int id, tlm::tlm_generic_payload& trans,
+                        sc_core::sc_time& delay )
+{
+    decode_cache& cache = decoded[id];
+    stats_scope   initiator( target_stats[id], trans, delay );
+    trace_scope   hop( *this, "route", trans, delay );
+
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = cache.decode( targets, addr );
+
+    if( target == address_map::npos ) {
+        trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+        return;
+    }
+    stats_scope slave( init_stats[target], trans, delay );
+
+    unsigned from = initiator_node[id];
+    unsigned to   = target_node[target];
+    unsigned data = flits_of( trans.get_data_length() );
+
+    // request: head, and the data of writes
+    sc_core::sc_time now  = sc_core::sc_time_stamp();
+    sc_core::sc_time sent = now + delay;
+    sc_core::sc_time arrived
+        = route( from, to, 1 + ( trans.is_write() ? data : 0 ), sent );
+    delay = arrived - now;
+
+    // forward with the address local to the target, restore it after
+    trans.set_address( cache.get_local_address( addr ) );
+    init_socket[target]->b_transport( trans, delay );
+    trans.set_address( addr );
+
+    // response: head, and the data of reads; the target may have
+    // waited
+    now = sc_core::sc_time_stamp();
+    sc_core::sc_time replied = now + delay;
+    sc_core::sc_time back
+        = route( to, from, 1 + ( trans.is_read() ? data : 0 ), replied );
+    delay = back - now;
+
+    packets += 2;
+    latency += ( arrived - sent ) + ( back - replied );
+}
+
+sc_core::sc_time mesh::route( unsigned from, unsigned to, unsigned flits,
+                              const sc_core::sc_time& at )
+{
+    const sc_core::sc_time pipeline = cycle * double( config.router );
+
+    unsigned x  = from % config.width, y  = from / config.width;
+    unsigned tx = to % config.width,   ty = to / config.width;
+
+    // X first, then Y, then out to the local node
+    sc_core::sc_time t = traverse( injection[from], flits, at );
+    while( true ) {
+        port p = x < tx ? east
+               : x > tx ? west
+               : y > ty ? north
+               : y < ty ? south
+               : local;
+
+        t += pipeline;
+        t = traverse( links[ ( y * config.width + x ) * ports + p ], flits, t );
+        if( p == local )
+            break;
+
+        switch( p ) {
+            case east:  ++x; break;
+            case west:  --x; break;
+            case north: --y; break;
+            case south: ++y; break;
+            default:         break;
+        }
+        ++hops;
+    }
+
+    // the tail follows the head
+    return t + cycle * double( ( flits - 1 ) * cycles_per_flit );
+}
+
+sc_core::sc_time mesh::traverse( link& l, unsigned flits,
+                                 const sc_core::sc_time& at )
+{
+    // a virtual channel is held until the tail has left, credits
+    // permitting; the wire carries one flit per cycle
+    const sc_core::sc_time hold = cycle * double( flits * cycles_per_flit );
+    const sc_core::sc_time wire = cycle * double( flits );
+
+    sc_core::sc_time t = at;
+    while( true ) {
+        // the virtual channel free first
+        unsigned         vc    = 0;
+        sc_core::sc_time start = l.vcs[0].find( t, hold );
+        for( unsigned v = 1; v < l.vcs.size(); ++v ) {
+            sc_core::sc_time s = l.vcs[v].find( t, hold );
+            if( s < start ) {
+                start = s;
+                vc    = v;
+            }
+        }
+
+        // then a slot on the wire, the channel has to be free then, too
+        sc_core::sc_time slot = l.wire.find( start, wire );
+        if( slot == start || l.vcs[vc].find( slot, hold ) == slot ) {
+            l.vcs[vc].reserve( slot, hold );
+            l.wire.reserve( slot, wire );
+            ++l.packets;
+            l.flits += flits;
+            return slot + cycle * double( config.link );
+        }
+        t = slot;
+    }
+}
+
+unsigned mesh::flits_of( unsigned length ) const
+{
+    unsigned words = ( length + sizeof(unsigned) - 1 ) / sizeof(unsigned);
+    return ( words + config.flit - 1 ) / config.flit;
+}
+
+bool mesh::get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                               tlm::tlm_dmi& dmi )
+{
+    decode_cache& cache = decoded[id];
+
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = cache.decode( targets, addr );
+
+    if( target == address_map::npos )
+        return false;
+
+    trans.set_address( cache.get_local_address( addr ) );
+    bool granted = init_socket[target]->get_direct_mem_ptr( trans, dmi );
+    trans.set_address( addr );
+
+    // the region (or the range DMI is denied for) is reported in the
+    // target's address space, translate it back
+    address_map::address_type start = dmi.get_start_address();
+    address_map::address_type end   = dmi.get_end_address();
+    targets.get_global_range( target, start, end );
+    dmi.set_start_address( start );
+    dmi.set_end_address( end );
+
+    return granted;
+}
+
+void mesh::invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                      sc_dt::uint64 end )
+{
+    address_map::address_type global_start = start;
+    address_map::address_type global_end   = end;
+    targets.get_global_range( id, global_start, global_end );
+
+    // we don't know who holds the pointer, tell every initiator
+    for( unsigned i = 0; i < target_socket.size(); ++i )
+        target_socket[i]->invalidate_direct_mem_ptr( global_start, global_end );
+}
+
+unsigned int mesh::transport_dbg( int /* id unused */,
+                                 tlm::tlm_generic_payload& trans )
+{
+    return route_dbg( targets, trans,
+        [this]( address_map::index_type target, tlm::tlm_generic_payload& t )
+        { return init_socket[target]->transport_dbg( t ); } );
+}
+
+void mesh::end_of_elaboration()
+{
+    address_map( init_socket.size(), mem_map.c_str() ).swap( targets );
+
+    sc_assert( init_socket.size() == targets.size() );
+
+    decoded.assign( target_socket.size(), decode_cache() );
+
+    // the rest at their default nodes
+    initiator_node.resize( target_socket.size(), unplaced );
+    for( unsigned i = 0; i < initiator_node.size(); ++i )
+        if( initiator_node[i] == unplaced )
+            initiator_node[i] = i % nodes();
+    target_node.resize( init_socket.size(), unplaced );
+    for( unsigned i = 0; i < target_node.size(); ++i )
+        if( target_node[i] == unplaced )
+            target_node[i] = i % nodes();
+
+    target_stats.resize( target_socket.size() );
+    init_stats.resize( init_socket.size() );
+    for( unsigned i = 0; i < target_stats.size(); ++i )
+        register_stats( *this, "target_socket", target_stats[i], i );
+    for( unsigned i = 0; i < init_stats.size(); ++i )
+        register_stats( *this, "init_socket", init_stats[i], i );
+}
+
+void mesh::end_of_simulation()
+{
+    sc_core::sc_time elapsed = sc_core::sc_time_stamp();
+
+    // utilisation of the wires between routers
+    double   busiest = 0, sum = 0;
+    unsigned used    = 0;
+    for( unsigned i = 0; i < links.size(); ++i ) {
+        if( i % ports == local || !links[i].packets
+            || elapsed == sc_core::SC_ZERO_TIME )
+            continue;
+        double u = links[i].wire.busy() / elapsed;
+        busiest = u > busiest ? u : busiest;
+        sum += u;
+        ++used;
+    }
+
+    std::cout << name() << ": " << config.width << "x" << config.height
+              << " nodes, " << packets << " packets";
+    if( packets )
+        std::cout << ", " << double( hops ) / packets << " hops and "
+                  << latency / double( packets ) << " per packet";
+    if( used )
+        std::cout << ", link utilisation " << 100. * sum / used
+                  << "% average, " << 100. * busiest << "% peak";
+    std::cout << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
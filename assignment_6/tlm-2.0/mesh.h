@@ -0,0 +1,163 @@
+#ifndef MESH_H_INCLUDED_
+#define MESH_H_INCLUDED_
+
+#include "address_map.h"
+#include "decode_cache.h"
+#include "stats.h"
+#include "timeline.h"
+
+#include <string>
+#include <vector>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+#include <systemc>
+
+#include <tlm_utils/multi_passthrough_target_socket.h>
+#include <tlm_utils/multi_passthrough_initiator_socket.h>
+#include <tlm.h>
+
+// Configuration of a mesh, from a list of 'key=value' settings (see
+// settings.h):
+//
+//   width=<n>    nodes per row (default: 2)
+//   height=<n>   rows of nodes (default: 2)
+//   vcs=<n>      virtual channels per link (default: 2)
+//   depth=<n>    flit buffers per virtual channel (default: 4)
+//   flit=<n>     words per flit (default: 2)
+//   cycle=<ns>   link cycle, one flit per cycle (default: 1)
+//   link=<n>     link latency in cycles (default: 1)
+//   router=<n>   router pipeline in cycles (default: 2)
+struct mesh_config
+{
+    mesh_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned width;
+    unsigned height;
+    unsigned vcs;
+    unsigned depth;
+    unsigned flit;
+    double   cycle;
+    unsigned link;
+    unsigned router;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// 2D-mesh network-on-chip
+//
+// Initiators and targets attach at nodes (see place_initiator and
+// place_target, both default to node 'index % nodes'), the target is
+// decoded from the memory map, as on the bus.  Node (x,y) is number
+// 'y * width + x'.  A transaction travels as a request packet to the
+// target's node and back as a response packet; packets carry a head
+// flit and the data flits of writes and reads, respectively.
+//
+// Packets are routed X first, then Y (deadlock free).  At every
+// router, the head spends the router pipeline, then takes the virtual
+// channel of the output link that is free first and the next slot on
+// the wire; the tail follows flit by flit (wormhole).  With credit
+// based flow control, a virtual channel sends 'depth' flits per
+// credit round trip (2 * link + router cycles) at most, so shallow
+// buffers slow a packet down even on an idle link.  Injection and
+// ejection at the network interfaces are links as well.
+//
+// Links are modelled by their busy timelines (see timeline.h), no
+// process runs in the network: transport annotates the time the
+// packets spend in it, also for temporally decoupled initiators.  A
+// packet blocked downstream does not hold the links behind it.
+//
+// DMI and debug transport are passed on like on the bus; direct and
+// debug accesses bypass the mesh.
+struct mesh
+: public sc_core::sc_module
+{
+    typedef mesh               this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::multi_passthrough_initiator_socket<this_type> init_socket;
+    tlm_utils::multi_passthrough_target_socket<this_type>    target_socket;
+
+    mesh( sc_core::sc_module_name, const mesh_config& config,
+          const char* mem_map = "mem_map.txt" );
+
+    unsigned nodes() const
+    { return config.width * config.height; }
+
+    // attach the initiator or target bound 'index'th at 'node', before
+    // the end of elaboration
+    void place_initiator( unsigned index, unsigned node );
+    void place_target( unsigned index, unsigned node );
+
+private:
+    // output ports of a router, the last one ejects to the local node
+    enum port { east, west, north, south, local, ports };
+
+    struct link
+    {
+        link() : vcs(), wire(), packets(), flits() {}
+
+        std::vector<timeline> vcs;
+        timeline              wire;
+        unsigned long         packets;
+        unsigned long long    flits;
+    };
+
+    // Loosely-Timed (Blocking Transport)
+    void b_transport( int id, tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay );
+
+    // Direct Memory Interface
+    bool get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                             tlm::tlm_dmi& dmi );
+    void invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                    sc_dt::uint64 end );
+
+    // Debug transport, in zero time and outside the network (see
+    // debug_transport.h)
+    unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
+    // time the tail of a packet of 'flits' sent at 'at' arrives
+    sc_core::sc_time route( unsigned from, unsigned to, unsigned flits,
+                            const sc_core::sc_time& at );
+
+    // time the head leaving the router at 'at' reaches the next one
+    sc_core::sc_time traverse( link& l, unsigned flits,
+                               const sc_core::sc_time& at );
+
+    unsigned flits_of( unsigned length ) const;
+
+    virtual void end_of_elaboration();
+    virtual void end_of_simulation();
+
+    mesh_config      config;
+    std::string      mem_map;
+    address_map      targets;
+    sc_core::sc_time cycle;
+    unsigned         cycles_per_flit; // of a virtual channel
+
+    // per node: injection, then one link per output port
+    std::vector<link> injection;
+    std::vector<link> links;
+
+    std::vector<unsigned> initiator_node;
+    std::vector<unsigned> target_node;
+
+    // last decoded region, one per initiator
+    std::vector<decode_cache> decoded;
+
+    unsigned long      packets;
+    unsigned long long hops;
+    sc_core::sc_time   latency; // in the network, sum
+
+    // traffic per initiator and per target, see stats.h
+    std::vector<socket_stats> target_stats;
+    std::vector<socket_stats> init_stats;
+};
+
+#endif // MESH_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,78 @@
+#include "monitor.h"
+
+#include <iostream> // std::cout, std::endl
+#include <sstream>  // std::stringstream
+
+monitor::monitor( sc_core::sc_module_name /* unused */, const char* filename,
+                  bool delta, bool allow_dmi )
+: base_type()
+, target_socket("target_socket")
+, init_socket("init_socket")
+, out()
+, allow_dmi( allow_dmi )
+, records()
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
+
+    if( !out.open( filename, delta ) ) {
+        std::stringstream s;
+        s << "cannot write capture " << filename << " - not recording";
+        SC_REPORT_WARNING( "Monitor/File", s.str().c_str() );
+    }
+}
+
+void monitor::b_transport( tlm::tlm_generic_payload& trans,
+                           sc_core::sc_time& delay )
+{
+    sc_core::sc_time issued = sc_core::sc_time_stamp() + delay;
+
+    init_socket->b_transport( trans, delay );
+
+    if( !allow_dmi )
+        trans.set_dmi_allowed( false );
+
+    if( !out.is_open() )
+        return;
+
+    capture::record r;
+    r.command = trans.get_command();
+    r.time    = std::uint64_t( issued.to_seconds() * 1e12 + 0.5 );
+    r.address = trans.get_address();
+    r.length  = trans.get_data_length();
+    r.data    = trans.is_read() || trans.is_write() ? trans.get_data_ptr()
+                                                    : NULL;
+    out.write( r );
+    ++records;
+}
+
+bool monitor::get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                                  tlm::tlm_dmi& dmi )
+{
+    // the default DMI object denies the whole address range
+    if( !allow_dmi )
+        return false;
+    return init_socket->get_direct_mem_ptr( trans, dmi );
+}
+
+void monitor::invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                         sc_dt::uint64 end )
+{
+    target_socket->invalidate_direct_mem_ptr( start, end );
+}
+
+unsigned int monitor::transport_dbg( tlm::tlm_generic_payload& trans )
+{
+    return init_socket->transport_dbg( trans );
+}
+
+void monitor::end_of_simulation()
+{
+    out.close();
+    std::cout << name() << ": " << records << " transactions recorded"
+              << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,53 @@
+#ifndef MONITOR_H_INCLUDED_
+#define MONITOR_H_INCLUDED_
+
+#include "capture_file.h"
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+
+// Transaction monitor: passes everything from target_socket on to
+// init_socket unchanged, and records each blocking transaction to a
+// capture file (see capture_file.h) when it completes, i.e. with the
+// read data returned by the target.
+//
+// Unless 'allow_dmi' is set, DMI is denied so that no access can
+// bypass the capture.
+struct monitor
+: public sc_core::sc_module
+{
+    typedef monitor            this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::simple_target_socket<this_type>    target_socket;
+    tlm_utils::simple_initiator_socket<this_type> init_socket;
+
+    monitor( sc_core::sc_module_name, const char* filename,
+             bool delta = false, bool allow_dmi = false );
+
+private:
+    // Loosely-Timed (Blocking Transport)
+    void b_transport( tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay );
+
+    // Direct Memory Interface
+    bool get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                             tlm::tlm_dmi& dmi );
+    void invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                    sc_dt::uint64 end );
+
+    // debug accesses are passed on, but not recorded
+    unsigned int transport_dbg( tlm::tlm_generic_payload& trans );
+
+    virtual void end_of_simulation();
+
+    capture::writer out;
+    bool            allow_dmi;
+    unsigned long   records;
+};
+
+#endif // MONITOR_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,248 @@
+// needs or1ksim, see the Makefile
+#ifdef WITH_OR1KSIM
+
+#include "or1ksim_iss.h"
+#include "tracer.h"
+
+#include <or1ksim.h>
+
+#include <algorithm> // std::reverse
+#include <chrono>    // std::chrono::steady_clock
+#include <cstring>   // std::memcpy
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+namespace {
+
+bool host_is_little_endian()
+{
+    const unsigned one = 1;
+    return *reinterpret_cast< const unsigned char* >( &one );
+}
+
+void swap_words( unsigned char* bytes, std::size_t length )
+{
+    for( std::size_t i = 0; i < length; i += sizeof(unsigned) )
+        std::reverse( bytes + i, bytes + i + sizeof(unsigned) );
+}
+
+} // anonymous namespace
+
+or1ksim_iss::or1ksim_iss( sc_core::sc_module_name /* unused */,
+                          const char* config_file, const char* image_file,
+                          bool use_dmi )
+: base_type()
+, init_socket( "init_socket" )
+, config_file( config_file )
+, image_file( image_file ? image_file : "" )
+, use_dmi( use_dmi )
+, swap()
+, dmi_regions()
+, batch_start()
+, stall()
+, data_buffer()
+, enable_buffer()
+, cycles(), batches(), reads(), writes(), direct(), errors()
+, stalled(), wall()
+{
+    static bool instantiated = false;
+    if( instantiated )
+        SC_REPORT_ERROR( "ISS/Instance", "only one or1ksim instance per simulation" );
+    instantiated = true;
+
+    SC_THREAD( run );
+    init_socket.bind( *this );
+}
+
+void or1ksim_iss::run()
+{
+    // the command line of or1ksim
+    std::vector<char*> argv;
+    argv.push_back( const_cast< char* >( "or1ksim" ) );
+    argv.push_back( const_cast< char* >( "-f" ) );
+    argv.push_back( const_cast< char* >( config_file.c_str() ) );
+    if( !image_file.empty() )
+        argv.push_back( const_cast< char* >( image_file.c_str() ) );
+    argv.push_back( NULL );
+
+    if( or1ksim_init( argv.size() - 1, &argv[0], this,
+                      &this_type::upcall_read, &this_type::upcall_write )
+        != OR1KSIM_RC_OK ) {
+        std::stringstream s;
+        s << "cannot start or1ksim with " << config_file;
+        SC_REPORT_ERROR( "ISS/Init", s.str().c_str() );
+        return;
+    }
+    swap = bool( or1ksim_is_le() ) != host_is_little_endian();
+
+    sc_core::sc_time batch = tlm::tlm_global_quantum::instance().get();
+    if( batch == sc_core::SC_ZERO_TIME )
+        batch = sc_core::sc_time( 1, sc_core::SC_US );
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point wall_start = clock::now();
+
+    int rc = OR1KSIM_RC_OK;
+    while( rc == OR1KSIM_RC_OK || rc == OR1KSIM_RC_BRKPT ) {
+        batch_start = sc_core::sc_time_stamp();
+        stall       = sc_core::SC_ZERO_TIME;
+
+        or1ksim_set_time_point();
+        rc = or1ksim_run( batch.to_seconds() );
+
+        double period = or1ksim_get_time_period();
+        cycles += (unsigned long long)( period * or1ksim_clock_rate() + .5 );
+        ++batches;
+        stalled += stall;
+
+        // the ISS stalls for the delays of its accesses
+        sc_core::sc_time end
+            = batch_start + sc_core::sc_time( period, sc_core::SC_SEC ) + stall;
+        if( end > sc_core::sc_time_stamp() )
+            wait( end - sc_core::sc_time_stamp() );
+        else
+            wait( sc_core::SC_ZERO_TIME );
+    }
+
+    wall = std::chrono::duration<double>( clock::now() - wall_start ).count();
+}
+
+int or1ksim_iss::upcall_read( void* self, unsigned long addr,
+                              unsigned char mask[], unsigned char rdata[],
+                              int length )
+{
+    return static_cast< this_type* >( self )
+        ->access( tlm::TLM_READ_COMMAND, addr, mask, rdata, length );
+}
+
+int or1ksim_iss::upcall_write( void* self, unsigned long addr,
+                               unsigned char mask[], unsigned char wdata[],
+                               int length )
+{
+    return static_cast< this_type* >( self )
+        ->access( tlm::TLM_WRITE_COMMAND, addr, mask, wdata, length );
+}
+
+int or1ksim_iss::access( tlm::tlm_command command, unsigned long addr,
+                         const unsigned char* mask, unsigned char* data,
+                         int length )
+{
+    bool write = command == tlm::TLM_WRITE_COMMAND;
+    ++( write ? writes : reads );
+
+    if( addr % sizeof(unsigned) || length <= 0
+        || length % sizeof(unsigned) ) {
+        std::stringstream s;
+        s << "unaligned access of " << length << " bytes to " << addr;
+        SC_REPORT_WARNING( "ISS/Access", s.str().c_str() );
+        ++errors;
+        return 1;
+    }
+
+    // in host byte order, the upcall's buffers stay untouched
+    data_buffer.assign( data, data + length );
+    enable_buffer.assign( mask, mask + length );
+    if( swap ) {
+        swap_words( &data_buffer[0], length );
+        swap_words( &enable_buffer[0], length );
+    }
+
+    bool all = true;
+    for( int i = 0; i < length; ++i )
+        all = all && enable_buffer[i] == tlm::TLM_BYTE_ENABLED;
+
+    tlm::tlm_generic_payload trans;
+    trans.set_command( command );
+    trans.set_address( addr / sizeof(unsigned) );
+    trans.set_data_ptr( &data_buffer[0] );
+    trans.set_data_length( length );
+    trans.set_streaming_width( length );
+    trans.set_byte_enable_ptr( all ? NULL : &enable_buffer[0] );
+    trans.set_byte_enable_length( all ? 0 : length );
+    trans.set_dmi_allowed( false );
+    trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    // the local time of the ISS, relative to the kernel's
+    sc_core::sc_time local = batch_start + stall
+        + sc_core::sc_time( or1ksim_get_time_period(), sc_core::SC_SEC );
+    sc_core::sc_time delay = local > sc_core::sc_time_stamp()
+        ? local - sc_core::sc_time_stamp() : sc_core::SC_ZERO_TIME;
+    sc_core::sc_time issued = sc_core::sc_time_stamp() + delay;
+
+    if( use_dmi && dmi_access( trans, delay ) ) {
+        ++direct;
+    } else {
+        trace_scope scope( *this, "transaction", trans, delay, true );
+        init_socket->b_transport( trans, delay );
+        if( use_dmi && trans.is_dmi_allowed() )
+            dmi_regions.request( init_socket, trans.get_address(),
+                                 trans.is_write() );
+    }
+    stall += sc_core::sc_time_stamp() + delay - issued;
+
+    if( trans.is_response_error() ) {
+        ++errors;
+        return 1;
+    }
+
+    if( !write ) {
+        if( swap )
+            swap_words( &data_buffer[0], length );
+        for( int i = 0; i < length; ++i )
+            if( mask[i] )
+                data[i] = data_buffer[i];
+    }
+    return 0;
+}
+
+bool or1ksim_iss::dmi_access( tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay )
+{
+    sc_dt::uint64 addr = trans.get_address();
+    sc_dt::uint64 last = addr + trans.get_data_length() / sizeof(unsigned) - 1;
+
+    // byte enables go to the target
+    if( trans.get_byte_enable_ptr()
+        || !( trans.is_read() || trans.is_write() ) )
+        return false;
+
+    const tlm::tlm_dmi* dmi = dmi_regions.find( addr, last, trans.is_write() );
+    if( !dmi )
+        return false;
+
+    // word addressed, see ram.h
+    unsigned char* word = dmi->get_dmi_ptr()
+        + ( addr - dmi->get_start_address() ) * sizeof(unsigned);
+
+    if( trans.is_read() ) {
+        std::memcpy( trans.get_data_ptr(), word, trans.get_data_length() );
+        delay += dmi->get_read_latency();
+    } else {
+        std::memcpy( word, trans.get_data_ptr(), trans.get_data_length() );
+        delay += dmi->get_write_latency();
+    }
+    trans.set_response_status( tlm::TLM_OK_RESPONSE );
+    return true;
+}
+
+void or1ksim_iss::invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                             sc_dt::uint64 end )
+{
+    dmi_regions.invalidate( start, end );
+}
+
+void or1ksim_iss::end_of_simulation()
+{
+    std::cout << name() << ": " << cycles << " cycles in " << batches
+              << " batches, " << reads << " reads, " << writes << " writes ("
+              << direct << " through DMI), " << errors << " errors, "
+              << stalled << " stalled" << std::endl;
+    if( wall > 0 )
+        std::cout << name() << ": " << wall << " s wall clock, "
+                  << cycles / wall / 1e6 << " M cycles per s"
+                  << " (instructions, at one per cycle)" << std::endl;
+}
+
+#endif // WITH_OR1KSIM
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,106 @@
+#ifndef OR1KSIM_ISS_H_INCLUDED_
+#define OR1KSIM_ISS_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+
+#include "dmi_cache.h"
+
+#include <string>
+#include <vector>
+
+// The or1ksim instruction-set simulator (libsim) as an LT initiator
+//
+// The ISS runs the embedded software in batches of one global quantum
+// (1 us without a quantum) per wait().  Its accesses to the 'generic'
+// peripherals of its configuration file come back as upcalls, which
+// become transactions on init_socket.  Map the platform's rams as
+// generic peripherals (and not as or1ksim memory), so that instruction
+// fetches and data accesses of the software all reach the platform.
+// The image is loaded by or1ksim, or preloaded into the rams in zero
+// time (see loader.h).
+//
+// ISS byte address 'a' is word 'a / 4' of the platform (see ram.h),
+// upcalls have to be word aligned.  Words are converted between the
+// byte order of the ISS and the host, the mask of an upcall becomes
+// the byte enables.  Once a target grants DMI, the upcalls to its
+// region are served from the DMI pointer.
+//
+// Transaction delays stall the ISS: a batch ends in kernel time after
+// the cycles the ISS ran plus the delays of its accesses.  The
+// simulation of the ISS ends when the software halts (l.nop 1).
+//
+// libsim keeps the ISS in global state, there can only be one.
+struct or1ksim_iss
+: public sc_core::sc_module
+, protected tlm::tlm_bw_transport_if<>
+{
+    typedef or1ksim_iss        this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+    or1ksim_iss( sc_core::sc_module_name, const char* config_file,
+                 const char* image_file = NULL, bool use_dmi = true );
+
+    tlm::tlm_initiator_socket<> init_socket;
+
+private:
+    void run();
+
+    // upcalls of libsim, 'self' is the instance; 0 on success
+    static int upcall_read( void* self, unsigned long addr,
+                            unsigned char mask[], unsigned char rdata[],
+                            int length );
+    static int upcall_write( void* self, unsigned long addr,
+                             unsigned char mask[], unsigned char wdata[],
+                             int length );
+
+    int access( tlm::tlm_command command, unsigned long addr,
+                const unsigned char* mask, unsigned char* data, int length );
+
+    // Direct Memory Interface, see master.h
+    bool dmi_access( tlm::tlm_generic_payload& trans,
+                     sc_core::sc_time& delay );
+
+    // tlm_bw_transport_if methods
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( tlm::tlm_generic_payload&, tlm::tlm_phase&,
+                     sc_core::sc_time& )
+    { return tlm::TLM_COMPLETED; }
+
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    virtual void end_of_simulation();
+
+    // member variables
+    std::string config_file;
+    std::string image_file;
+    bool        use_dmi;
+    bool        swap; // byte order of the ISS differs from the host's
+
+    // DMI regions granted so far
+    dmi_cache dmi_regions;
+
+    // the current batch: its start, and the delays of its accesses
+    sc_core::sc_time batch_start;
+    sc_core::sc_time stall;
+
+    // data and byte enables of an upcall, in host byte order
+    std::vector<unsigned char> data_buffer;
+    std::vector<unsigned char> enable_buffer;
+
+    // statistics
+    unsigned long long cycles;
+    unsigned long      batches;
+    unsigned long      reads;
+    unsigned long      writes;
+    unsigned long      direct;   // of reads and writes, through DMI
+    unsigned long      errors;
+    sc_core::sc_time   stalled;
+    double             wall;     // s
+}; // or1ksim_iss
+
+#endif // OR1KSIM_ISS_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,72 @@
+#include "payload_pool.h"
+
+// payload and its data buffer, allocated together
+struct payload_pool::payload
+: public tlm::tlm_generic_payload
+{
+    payload( tlm::tlm_mm_interface* mm, unsigned data_size )
+    : tlm::tlm_generic_payload( mm )
+    , data( data_size )
+    {}
+
+    std::vector<unsigned char> data;
+};
+
+payload_pool::payload_pool( unsigned data_size,
+                            const sc_core::sc_object* owner )
+: data_size( data_size )
+, owner( owner )
+, allocations( 0 )
+, pool()
+, free_list()
+{
+    sc_assert( data_size > 0 );
+}
+
+payload_pool::~payload_pool()
+{
+    for( unsigned i = 0; i < pool.size(); ++i )
+        delete pool[i];
+}
+
+tlm::tlm_generic_payload* payload_pool::allocate()
+{
+    if( free_list.empty() ) {
+        pool.push_back( new payload( this, data_size ) );
+        free_list.reserve( pool.size() );
+        free( pool.back() );
+    }
+
+    tlm::tlm_generic_payload* trans = free_list.back();
+    free_list.pop_back();
+
+    trans->acquire();
+    ++allocations;
+    return trans;
+}
+
+void payload_pool::free( tlm::tlm_generic_payload* trans )
+{
+    // frees auto extensions only, the others are recycled
+    trans->reset();
+
+    payload* p = static_cast< payload* >( trans );
+    trans->set_data_ptr( &p->data[0] );
+    trans->set_data_length( data_size );
+    trans->set_streaming_width( data_size );
+    trans->set_byte_enable_ptr( NULL );
+    trans->set_byte_enable_length( 0 );
+    trans->set_dmi_allowed( false );
+    trans->set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    free_list.push_back( trans );
+}
+
+const sc_core::sc_object*
+payload_pool::owner_of( const tlm::tlm_generic_payload& trans )
+{
+    const payload_pool* pool = dynamic_cast< const payload_pool* >( trans.get_mm() );
+    return pool ? pool->owner : NULL;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,54 @@
+#ifndef PAYLOAD_POOL_H_INCLUDED_
+#define PAYLOAD_POOL_H_INCLUDED_
+
+#include <tlm.h>
+
+#include <vector>
+
+// Memory manager for generic payloads
+//
+// Payloads come with a data buffer of 'data_size' bytes and go back to
+// a free list once their reference count drops to zero.  Extensions
+// set with set_extension() stay attached and are reused with the
+// payload, auto extensions are freed on release.  Once the pool has
+// grown to the number of transactions in flight, allocate() and
+// release() don't touch the heap anymore.
+//
+// The optional owner names the initiator the payloads belong to, so
+// that targets can tell initiators apart (see owner_of).
+class payload_pool
+: public tlm::tlm_mm_interface
+{
+public:
+    explicit payload_pool( unsigned data_size = sizeof(unsigned),
+                           const sc_core::sc_object* owner = NULL );
+    ~payload_pool();
+
+    // payload with a reference count of one, data pointer and length
+    // set to the buffer of the payload
+    tlm::tlm_generic_payload* allocate();
+
+    // payloads ever created, and handed out
+    unsigned long created() const   { return pool.size(); }
+    unsigned long allocated() const { return allocations; }
+
+    // owner of a pooled payload, NULL for other payloads
+    static const sc_core::sc_object*
+    owner_of( const tlm::tlm_generic_payload& trans );
+
+private:
+    // called by tlm_generic_payload::release()
+    virtual void free( tlm::tlm_generic_payload* trans );
+
+    struct payload;
+
+    unsigned                               data_size;
+    const sc_core::sc_object*              owner;
+    unsigned long                          allocations;
+    std::vector<payload*>                  pool;
+    std::vector<tlm::tlm_generic_payload*> free_list;
+};
+
+#endif // PAYLOAD_POOL_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
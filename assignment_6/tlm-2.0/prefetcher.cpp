@@ -0,0 +1,446 @@
+#include "prefetcher.h"
+#include "settings.h"
+
+#include <algorithm> // std::min, std::max
+#include <cstring>   // std::memcpy
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+prefetch_config::prefetch_config()
+: window( 16 )
+, threshold( 2 )
+, combine( 8 )
+, latency( 1 )
+, timeout( 100 )
+{}
+
+bool prefetch_config::parse( const char* spec )
+{
+    return parse_settings( spec, "Prefetcher",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool prefetch_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    bool              ok = true;
+
+    if( key == "window" ) {
+        ok = ( in >> window ) && window > 0;
+    } else if( key == "threshold" ) {
+        ok = ( in >> threshold ) && threshold > 0;
+    } else if( key == "combine" ) {
+        ok = ( in >> combine ) && combine > 0;
+    } else if( key == "latency" ) {
+        ok = ( in >> latency ) && latency >= 0;
+    } else if( key == "timeout" ) {
+        ok = ( in >> timeout ) && timeout >= 0;
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+prefetcher::stream::stream()
+: last(), stride(), confidence()
+, buffered(), buffer_start(), buffer(), used(), ready()
+, write_start(), write_data(), write_since()
+, reads(), read_hits(), prefetches(), prefetched(), useful()
+, writes(), write_bursts()
+{}
+
+prefetcher::prefetcher( sc_core::sc_module_name /* unused */,
+                        const prefetch_config& config )
+: base_type()
+, target_socket("target_socket")
+, init_socket("init_socket")
+, config( config )
+, latency( config.latency, sc_core::SC_NS )
+, timeout( config.timeout, sc_core::SC_NS )
+, streams()
+, port()
+, drain_event()
+, downstream()
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+
+    SC_THREAD( drain );
+}
+
+void prefetcher::end_of_elaboration()
+{
+    streams.resize( target_socket.size() );
+}
+
+void prefetcher::b_transport( int id, tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay )
+{
+    stream& s = streams[id];
+    port.lock();
+
+    if( trans.is_read() )
+        read( s, trans, delay );
+    else if( trans.is_write() )
+        write( s, trans, delay );
+    else
+        forward( trans, delay );
+
+    trans.set_dmi_allowed( false );
+    port.unlock();
+}
+
+bool prefetcher::get_direct_mem_ptr( int /* id unused */,
+                                     tlm::tlm_generic_payload& /* trans unused */,
+                                     tlm::tlm_dmi& /* dmi unused */ )
+{
+    // the default DMI object denies the whole address range
+    return false;
+}
+
+// plain bursts of whole words, the only ones buffered
+static bool is_plain( const tlm::tlm_generic_payload& trans )
+{
+    unsigned length = trans.get_data_length();
+    return !trans.get_byte_enable_ptr()
+        && length && length % sizeof(unsigned) == 0
+        && trans.get_streaming_width() >= length;
+}
+
+unsigned int prefetcher::transport_dbg( int /* id unused */,
+                                       tlm::tlm_generic_payload& trans )
+{
+    sc_dt::uint64  addr  = trans.get_address();
+    unsigned       words = ( trans.get_data_length() + sizeof(unsigned) - 1 )
+                           / sizeof(unsigned);
+    unsigned char* bytes = trans.get_data_ptr();
+    bool           write = trans.is_write();
+
+    if( !( trans.is_read() || write ) || !is_plain( trans ) ) {
+        // the combined writes go first, the target sorts out the bytes
+        for( unsigned id = 0; id < streams.size(); ++id ) {
+            stream& s = streams[id];
+            if( s.write_data.empty() || addr >= s.write_start + s.write_data.size()
+                || s.write_start >= addr + words )
+                continue;
+            if( !transfer( tlm::TLM_WRITE_COMMAND, s.write_start,
+                           &s.write_data[0], s.write_data.size(), NULL ) )
+                SC_REPORT_WARNING( "Prefetcher/Debug",
+                                   "combined write lost to a debug access" );
+            s.write_data.clear();
+        }
+        unsigned int done = init_socket->transport_dbg( trans );
+        if( write )
+            update( addr, words, NULL );
+        return done;
+    }
+
+    unsigned int done = init_socket->transport_dbg( trans );
+    words = done / sizeof(unsigned);
+    if( write )
+        update( addr, words, bytes );
+
+    // the combined writes are newer than the memory
+    for( unsigned id = 0; id < streams.size(); ++id ) {
+        stream& s = streams[id];
+        if( s.write_data.empty() )
+            continue;
+
+        sc_dt::uint64 first = std::max( addr, s.write_start );
+        sc_dt::uint64 last  = std::min( addr + words,
+                                        s.write_start + s.write_data.size() );
+        if( first >= last )
+            continue;
+
+        unsigned char* buffered = reinterpret_cast< unsigned char* >(
+            &s.write_data[ first - s.write_start ] );
+        unsigned char* data = bytes + ( first - addr ) * sizeof(unsigned);
+        if( write )
+            std::memcpy( buffered, data, ( last - first ) * sizeof(unsigned) );
+        else
+            std::memcpy( data, buffered, ( last - first ) * sizeof(unsigned) );
+    }
+    return done;
+}
+
+void prefetcher::read( stream& s, tlm::tlm_generic_payload& trans,
+                       sc_core::sc_time& delay )
+{
+    sc_dt::uint64 addr  = trans.get_address();
+    unsigned      words = ( trans.get_data_length() + sizeof(unsigned) - 1 )
+                          / sizeof(unsigned);
+
+    ++s.reads;
+    flush_range( addr, words, delay );
+
+    if( !is_plain( trans ) ) {
+        forward( trans, delay );
+        return;
+    }
+
+    // the same distance as last time makes a stream
+    long long stride = (long long)( addr - s.last );
+    if( stride == s.stride ) {
+        ++s.confidence;
+    } else {
+        s.stride     = stride;
+        s.confidence = 1;
+    }
+    s.last = addr;
+
+    if( s.buffered && addr >= s.buffer_start
+        && addr + words <= s.buffer_start + s.buffer.size() ) {
+        unsigned offset = addr - s.buffer_start;
+        std::memcpy( trans.get_data_ptr(), &s.buffer[offset],
+                     words * sizeof(unsigned) );
+        for( unsigned i = offset; i < offset + words; ++i ) {
+            if( !s.used[i] ) {
+                s.used[i] = true;
+                ++s.useful;
+            }
+        }
+        ++s.read_hits;
+
+        // the prefetch may still be on its way
+        sc_core::sc_time now = sc_core::sc_time_stamp() + delay;
+        if( now < s.ready )
+            delay += s.ready - now;
+        delay += latency;
+        trans.set_response_status( tlm::TLM_OK_RESPONSE );
+    } else {
+        forward( trans, delay );
+        if( trans.is_response_error() )
+            return;
+    }
+
+    // the next read has to fit into the window
+    if( s.confidence < config.threshold || !stride
+        || (unsigned long long)( stride < 0 ? -stride : stride ) + words
+           > config.window
+        || ( stride < 0 && addr < sc_dt::uint64( -stride ) ) )
+        return;
+
+    sc_dt::uint64 next = addr + stride;
+    if( !s.buffered || next < s.buffer_start
+        || next + words > s.buffer_start + s.buffer.size() )
+        prefetch( s, next, words, delay );
+}
+
+void prefetcher::prefetch( stream& s, sc_dt::uint64 next, unsigned words,
+                           sc_core::sc_time delay )
+{
+    // ahead in the direction of the stream, starting with 'next'
+    sc_dt::uint64 start = next;
+    if( s.stride < 0 )
+        start = next + words > config.window ? next + words - config.window : 0;
+
+    // issued when the triggering read completes, in the background
+    flush_range( start, config.window, delay );
+
+    s.buffer.resize( config.window );
+    s.used.assign( config.window, false );
+    s.buffer_start = start;
+    ++s.prefetches;
+
+    s.buffered = transfer( tlm::TLM_READ_COMMAND, start, &s.buffer[0],
+                           config.window, &delay );
+    if( !s.buffered )
+        return; // e.g. beyond the end of a slave
+
+    s.prefetched += config.window;
+    s.ready       = sc_core::sc_time_stamp() + delay;
+}
+
+void prefetcher::write( stream& s, tlm::tlm_generic_payload& trans,
+                        sc_core::sc_time& delay )
+{
+    sc_dt::uint64        addr  = trans.get_address();
+    unsigned             words = ( trans.get_data_length() + sizeof(unsigned) - 1 )
+                                 / sizeof(unsigned);
+    const unsigned char* bytes = trans.get_data_ptr();
+
+    ++s.writes;
+
+    if( !is_plain( trans ) || words > config.combine ) {
+        flush_range( addr, words, delay );
+        update( addr, words, NULL );
+        forward( trans, delay );
+        return;
+    }
+    update( addr, words, bytes );
+
+    // a write elsewhere passes the collected ones on in the background
+    sc_core::sc_time background = delay;
+    if( !s.write_data.empty()
+        && ( addr != s.write_start + s.write_data.size()
+             || s.write_data.size() + words > config.combine ) )
+        flush( s, background );
+
+    // older writes of other initiators must not overwrite this one
+    flush_range( addr, words, background );
+
+    if( s.write_data.empty() ) {
+        s.write_start = addr;
+        s.write_since = sc_core::sc_time_stamp() + delay;
+        drain_event.notify( delay + timeout );
+    }
+
+    const unsigned* data = reinterpret_cast< const unsigned* >( bytes );
+    s.write_data.insert( s.write_data.end(), data, data + words );
+
+    delay += latency;
+    trans.set_response_status( tlm::TLM_OK_RESPONSE );
+
+    if( s.write_data.size() == config.combine ) {
+        background = delay;
+        flush( s, background );
+    }
+}
+
+void prefetcher::update( sc_dt::uint64 addr, unsigned words,
+                         const unsigned char* data )
+{
+    for( unsigned id = 0; id < streams.size(); ++id ) {
+        stream& s = streams[id];
+        if( !s.buffered || addr >= s.buffer_start + s.buffer.size()
+            || addr + words <= s.buffer_start )
+            continue;
+
+        if( !data ) {
+            s.buffered = false;
+            continue;
+        }
+
+        // copy the overlapping part
+        sc_dt::uint64 first = std::max( addr, s.buffer_start );
+        sc_dt::uint64 last  = std::min( addr + words,
+                                        s.buffer_start + s.buffer.size() );
+        std::memcpy( &s.buffer[ first - s.buffer_start ],
+                     data + ( first - addr ) * sizeof(unsigned),
+                     ( last - first ) * sizeof(unsigned) );
+    }
+}
+
+void prefetcher::flush( stream& s, sc_core::sc_time& delay )
+{
+    if( s.write_data.empty() )
+        return;
+
+    ++s.write_bursts;
+    if( !transfer( tlm::TLM_WRITE_COMMAND, s.write_start, &s.write_data[0],
+                   s.write_data.size(), &delay ) ) {
+        // let the target tell the good words from the bad ones
+        for( unsigned i = 0; i < s.write_data.size(); ++i ) {
+            if( transfer( tlm::TLM_WRITE_COMMAND, s.write_start + i,
+                          &s.write_data[i], 1, &delay ) )
+                continue;
+
+            std::stringstream msg;
+            msg << "posted write to address " << s.write_start + i
+                << " failed - ignored";
+            SC_REPORT_WARNING( "Prefetcher/Write", msg.str().c_str() );
+        }
+    }
+    s.write_data.clear();
+}
+
+void prefetcher::flush_range( sc_dt::uint64 addr, unsigned words,
+                              sc_core::sc_time& delay )
+{
+    for( unsigned id = 0; id < streams.size(); ++id ) {
+        stream& s = streams[id];
+        if( !s.write_data.empty() && addr < s.write_start + s.write_data.size()
+            && s.write_start < addr + words )
+            flush( s, delay );
+    }
+}
+
+void prefetcher::drain()
+{
+    for(;;) {
+        wait( drain_event );
+        port.lock();
+
+        sc_core::sc_time now  = sc_core::sc_time_stamp();
+        sc_core::sc_time next = sc_core::SC_ZERO_TIME;
+        for( unsigned id = 0; id < streams.size(); ++id ) {
+            stream& s = streams[id];
+            if( s.write_data.empty() )
+                continue;
+
+            sc_core::sc_time due = s.write_since + timeout;
+            if( due <= now ) {
+                sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+                flush( s, delay );
+            } else if( next == sc_core::SC_ZERO_TIME || due - now < next ) {
+                next = due - now;
+            }
+        }
+
+        port.unlock();
+        if( next != sc_core::SC_ZERO_TIME )
+            drain_event.notify( next );
+    }
+}
+
+bool prefetcher::transfer( tlm::tlm_command command, sc_dt::uint64 addr,
+                           unsigned* data, unsigned words,
+                           sc_core::sc_time* delay )
+{
+    unsigned length = words * sizeof(unsigned);
+
+    tlm::tlm_generic_payload trans;
+    trans.set_command( command );
+    trans.set_address( addr );
+    trans.set_data_ptr( reinterpret_cast< unsigned char* >( data ) );
+    trans.set_data_length( length );
+    trans.set_streaming_width( length );
+    trans.set_byte_enable_ptr( NULL );
+    trans.set_dmi_allowed( false );
+    trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    if( !delay )
+        return init_socket->transport_dbg( trans ) == length;
+
+    init_socket->b_transport( trans, *delay );
+    ++downstream;
+
+    return !trans.is_response_error();
+}
+
+void prefetcher::forward( tlm::tlm_generic_payload& trans,
+                          sc_core::sc_time& delay )
+{
+    init_socket->b_transport( trans, delay );
+    ++downstream;
+}
+
+void prefetcher::end_of_simulation()
+{
+    unsigned long requests = 0;
+    for( unsigned id = 0; id < streams.size(); ++id ) {
+        const stream& s = streams[id];
+        requests += s.reads + s.writes;
+
+        std::cout << name() << " initiator " << id << ": "
+                  << s.reads << " reads, "
+                  << s.read_hits << " from the stream buffer";
+        if( s.reads )
+            std::cout << " (coverage " << 100. * s.read_hits / s.reads << "%)";
+        std::cout << ", " << s.prefetches << " prefetches of "
+                  << s.prefetched << " words, " << s.useful << " used";
+        if( s.prefetched )
+            std::cout << " (accuracy " << 100. * s.useful / s.prefetched << "%)";
+        std::cout << ", " << s.writes << " writes, "
+                  << s.write_bursts << " combined bursts" << std::endl;
+    }
+    std::cout << name() << ": " << requests << " transactions requested, "
+              << downstream << " passed on, "
+              << (long)requests - (long)downstream << " saved" << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
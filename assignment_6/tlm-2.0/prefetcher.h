@@ -0,0 +1,163 @@
+#ifndef PREFETCHER_H_INCLUDED_
+#define PREFETCHER_H_INCLUDED_
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+#include <tlm_utils/simple_initiator_socket.h>
+
+#include <string>
+#include <vector>
+
+// Configuration of a prefetcher, from a list of 'key=value' settings
+// (see settings.h); sizes are in words, like addresses (see ram.h):
+//
+//   window=<n>    words fetched ahead of a detected stream (default: 16)
+//   threshold=<n> repetitions of a stride before prefetching starts
+//                 (default: 2)
+//   combine=<n>   largest combined write burst (default: 8)
+//   latency=<ns>  time to serve a read from the stream buffer or to
+//                 accept a write (default: 1)
+//   timeout=<ns>  combined writes are passed on at the latest after
+//                 this time (default: 100)
+struct prefetch_config
+{
+    prefetch_config();
+
+    // returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    unsigned window;
+    unsigned threshold;
+    unsigned combine;
+    double   latency;
+    double   timeout;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// Stride prefetcher and write-combining buffer between initiators and
+// the interconnect
+//
+// For every initiator, the distance between the addresses of
+// consecutive reads is tracked.  Once it repeated 'threshold' times,
+// the next 'window' words in the direction of the stride are read
+// with a single burst into the initiator's stream buffer, which then
+// serves the following reads.  The prefetch is issued along with the
+// triggering read, its data becomes available when its (annotated)
+// transfer completes.
+//
+// Plain writes of up to 'combine' words that continue the previous
+// write of an initiator are collected and passed on as one burst.
+// Such writes are acknowledged right away (posted).  A combined burst
+// the target rejects (e.g. one crossing the end of a slave) is passed
+// on word by word, failing words are reported as warnings.
+//
+// Reads and uncombined writes first pass on the combined writes they
+// overlap, and writes update the prefetched data they overlap.
+// Accesses bypassing this module (e.g. DMI, which is denied here) are
+// not seen.
+//
+// Debug transport sees the combined writes not passed on yet, and
+// its writes update them and the stream buffers, in zero time.
+struct prefetcher
+: public sc_core::sc_module
+{
+    typedef prefetcher         this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+
+    tlm_utils::multi_passthrough_target_socket<this_type> target_socket;
+    tlm_utils::simple_initiator_socket<this_type>         init_socket;
+
+    prefetcher( sc_core::sc_module_name, const prefetch_config& config );
+
+private:
+    // state and statistics of one initiator
+    struct stream
+    {
+        stream();
+
+        // stride detection
+        sc_dt::uint64 last;
+        long long     stride;
+        unsigned      confidence;
+
+        // stream buffer
+        bool                  buffered;
+        sc_dt::uint64         buffer_start;
+        std::vector<unsigned> buffer;
+        std::vector<bool>     used;
+        sc_core::sc_time      ready;
+
+        // write combining
+        sc_dt::uint64         write_start;
+        std::vector<unsigned> write_data;
+        sc_core::sc_time      write_since;
+
+        unsigned long      reads;
+        unsigned long      read_hits;     // served from the stream buffer
+        unsigned long      prefetches;
+        unsigned long long prefetched;    // words
+        unsigned long long useful;        // prefetched words read
+        unsigned long      writes;
+        unsigned long      write_bursts;  // combined writes passed on
+    };
+
+    // Loosely-Timed (Blocking Transport)
+    void b_transport( int id, tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay );
+
+    // Direct Memory Interface (denied)
+    bool get_direct_mem_ptr( int id, tlm::tlm_generic_payload& trans,
+                             tlm::tlm_dmi& dmi );
+
+    // Debug transport
+    unsigned int transport_dbg( int id, tlm::tlm_generic_payload& trans );
+
+    void read( stream& s, tlm::tlm_generic_payload& trans,
+               sc_core::sc_time& delay );
+    void write( stream& s, tlm::tlm_generic_payload& trans,
+                sc_core::sc_time& delay );
+
+    // fills the stream buffer around the read following 'addr'
+    void prefetch( stream& s, sc_dt::uint64 addr, unsigned words,
+                   sc_core::sc_time delay );
+
+    // brings the stream buffers in line with a write, NULL drops them
+    void update( sc_dt::uint64 addr, unsigned words,
+                 const unsigned char* data );
+
+    // passes on the combined writes (overlapping [addr,addr+words))
+    void flush( stream& s, sc_core::sc_time& delay );
+    void flush_range( sc_dt::uint64 addr, unsigned words,
+                      sc_core::sc_time& delay );
+
+    // by debug transport without 'delay'
+    bool transfer( tlm::tlm_command command, sc_dt::uint64 addr,
+                   unsigned* data, unsigned words, sc_core::sc_time* delay );
+    void forward( tlm::tlm_generic_payload& trans, sc_core::sc_time& delay );
+
+    // passes on combined writes older than the timeout
+    void drain();
+
+    virtual void end_of_elaboration();
+    virtual void end_of_simulation();
+
+    prefetch_config     config;
+    sc_core::sc_time    latency;
+    sc_core::sc_time    timeout;
+    std::vector<stream> streams;
+
+    // one access downstream at a time
+    sc_core::sc_mutex   port;
+    sc_core::sc_event   drain_event;
+
+    unsigned long       downstream; // transactions passed on
+};
+
+#endif // PREFETCHER_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
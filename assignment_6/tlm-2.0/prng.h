@@ -0,0 +1,46 @@
+#ifndef PRNG_H_INCLUDED_
+#define PRNG_H_INCLUDED_
+
+#include <cstdint>
+
+// Small, fast pseudo random number generator (xorshift64*)
+//
+// Each component keeps its own instance, so a run is reproducible for
+// a given seed regardless of the order in which processes execute.
+struct prng
+{
+    explicit prng( std::uint64_t seed = 1 )
+    { this->seed( seed ); }
+
+    void seed( std::uint64_t s )
+    {
+        // splitmix64 step, spreads similar seeds and avoids zero
+        s += 0x9E3779B97F4A7C15ull;
+        s  = ( s ^ ( s >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        s  = ( s ^ ( s >> 27 ) ) * 0x94D049BB133111EBull;
+        state = ( s ^ ( s >> 31 ) ) | 1;
+    }
+
+    std::uint64_t operator()()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // uniformly distributed in [0,n), n > 0
+    std::uint64_t below( std::uint64_t n )
+    { return ( (*this)() >> 11 ) % n; }
+
+    // true with a probability of 'percent'/100
+    bool percent( unsigned percent )
+    { return below( 100 ) < percent; }
+
+private:
+    std::uint64_t state;
+};
+
+#endif // PRNG_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -1,23 +1,229 @@
 
 #include "ram.h"
+#include "tracer.h"
 
-#include <sstream> // std::stringstream
+#include <algorithm> // std::min
+#include <cstring>   // std::memcpy
+#include <sstream>   // std::stringstream
 
-/* FILLME: constructor implementation */
-// TODO: constructor is only defined in .h file, but we need to give it an implementation
-// TODO: Bind us to our own export?
+ram::ram( sc_core::sc_module_name /* unused */, unsigned size,
+          sc_core::sc_time latency, ram_storage* storage )
+: base_type()
+, target_socket( "target_socket" )
+, latency( latency )
+, dmi_enabled( true )
+, target_stats()
+, mem( storage ? storage : new flat_storage( size ) )
+{
+    sc_assert( mem->size() == size );
+    target_socket.bind( *this );
+    register_stats( *this, "target_socket", target_stats );
+    checkpoint::instance().add( name(), *this );
+}
+
+ram::~ram()
+{
+    delete mem;
+}
+
+void ram::b_transport( tlm::tlm_generic_payload& trans,
+                       sc_core::sc_time& delay )
+{
+    stats_scope scope( target_stats, trans, delay );
+    trace_scope hop( *this, "service", trans, delay );
+
+    unsigned words = access( trans );
+    if( !words )
+        return;
+
+    // annotate instead of wait(), the initiator decides when to sync
+    delay += access_time( trans.get_address(), words, trans.is_write(), delay );
+
+    // the memory can be accessed directly
+    trans.set_dmi_allowed( dmi_enabled );
+}
+
+unsigned ram::access( tlm::tlm_generic_payload& trans )
+{
+    unsigned addr   = trans.get_address();
+    unsigned length = trans.get_data_length();
+    unsigned width  = trans.get_streaming_width();
+
+    // bursts and streams are made of whole words
+    if( length == 0 || length % sizeof(unsigned)
+        || width == 0 || width % sizeof(unsigned) ) {
+        trans.set_response_status( tlm::TLM_BURST_ERROR_RESPONSE );
+        return 0;
+    }
+
+    // a stream wraps around after 'width' bytes, so only the first
+    // 'width' bytes of the burst are distinct addresses
+    unsigned words = std::min( length, width ) / sizeof(unsigned);
+
+    if( is_invalid_address( addr, words ) ) {
+        trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+        return 0;
+    }
+
+    unsigned char* be     = trans.get_byte_enable_ptr();
+    unsigned       be_len = trans.get_byte_enable_length();
+
+    if( be && be_len == 0 ) {
+        trans.set_response_status( tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE );
+        return 0;
+    }
+
+    unsigned char* data  = trans.get_data_ptr();
+    bool           write = trans.is_write();
+    unsigned       first, last;
+
+    if( trans.is_read() || write ) {
+        if( !be && width >= length ) {
+            // contiguous burst, one copy per block of the backing store
+            for( std::size_t done = 0; done < length; ) {
+                unsigned  a     = addr + done / sizeof(unsigned);
+                unsigned* block = storage_block( a, write, first, last );
+
+                unsigned char* base
+                    = reinterpret_cast< unsigned char* >( block + ( a - first ) );
+                std::size_t n = std::min( std::size_t( length ) - done,
+                    ( std::size_t( last ) - a + 1 ) * sizeof(unsigned) );
+
+                if( write )
+                    std::memcpy( base, data + done, n );
+                else
+                    std::memcpy( data + done, base, n );
+                done += n;
+            }
+        } else {
+            for( unsigned i = 0; i < length; ++i ) {
+                if( be && be[ i % be_len ] == tlm::TLM_BYTE_DISABLED )
+                    continue;
+
+                unsigned  offset = i % width;
+                unsigned  a      = addr + offset / sizeof(unsigned);
+                unsigned* block  = storage_block( a, write, first, last );
+
+                unsigned char* byte
+                    = reinterpret_cast< unsigned char* >( block + ( a - first ) )
+                    + offset % sizeof(unsigned);
+                if( write )
+                    *byte = data[i];
+                else
+                    data[i] = *byte;
+            }
+        }
+    }
+
+    trans.set_response_status( tlm::TLM_OK_RESPONSE );
+    return words;
+}
+
+tlm::tlm_sync_enum
+ram::nb_transport_fw( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
+                      sc_core::sc_time& delay )
+{
+    if( phase != tlm::BEGIN_REQ ) {
+        SC_REPORT_ERROR( "RAM/Protocol", "unexpected phase" );
+        return tlm::TLM_COMPLETED;
+    }
+
+    // early completion: skip END_REQ, BEGIN_RESP and END_RESP
+    b_transport( trans, delay );
+    return tlm::TLM_COMPLETED;
+}
+
+bool ram::get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                              tlm::tlm_dmi& dmi )
+{
+    unsigned addr = trans.get_address();
+    if( !dmi_enabled || addr >= mem->size() )
+        return false;
+
+    // the block around addr; reads of words not written yet get the
+    // placeholder, write DMI waits for a write request
+    bool      write = trans.is_write();
+    unsigned  first, last;
+    unsigned* block = storage_block( addr, write, first, last );
+
+    dmi.set_dmi_ptr( reinterpret_cast< unsigned char* >( block ) );
+    dmi.set_start_address( first );
+    dmi.set_end_address( last );
+    dmi.set_read_latency( latency );
+    dmi.set_write_latency( latency );
+    if( write || !mem->placeholder( addr ) )
+        dmi.allow_read_write();
+    else
+        dmi.allow_read();
+    return true;
+}
 
-/* FILLME: b_transport implementation */
-// TODO: Interessantester Teil der Aufgabe - wie macht man das?
-// tlm_generic_payload& trans
-// trans.get_address(), trans.get_data_length(), trans.get_streaming_width() !
+unsigned* ram::storage_block( unsigned addr, bool write,
+                              unsigned& first, unsigned& last )
+{
+    // the first write replaces a placeholder, revoke the read-only DMI
+    // granted to it
+    bool      revoke = write && dmi_enabled && mem->placeholder( addr );
+    unsigned* block  = mem->block( addr, write, first, last );
+    if( revoke )
+        target_socket->invalidate_direct_mem_ptr( first, last );
+    return block;
+}
 
-/* FILLME: check for valid address request
- *         returns false, if address is valid,
- *         true (with error report) otherwise
+unsigned int ram::transport_dbg( tlm::tlm_generic_payload& trans )
+{
+    if( !access( trans ) )
+        return 0;
+    return trans.get_data_length();
+}
+
+sc_core::sc_time ram::access_time( unsigned /* addr unused */,
+                                   unsigned /* words unused */,
+                                   bool /* write unused */,
+                                   const sc_core::sc_time& /* delay unused */ )
+{
+    return latency;
+}
+
+bool ram::save_state( state_type& state, const std::string& prefix )
+{
+    state.push_back( mem->size() );
+    return save_storage( *mem, ( prefix + "." + name() ).c_str() );
+}
+
+bool ram::restore_state( const state_type& state )
+{
+    if( state.size() != 1 || state[0] != mem->size() )
+        return false;
+
+    // the contents are mapped from the image by the owner (see main's
+    // -K), resuming on zeros instead would go unnoticed
+    if( !mem->from_image() ) {
+        std::stringstream s;
+        s << name() << ": missing or incomplete image of the checkpoint";
+        SC_REPORT_ERROR( "Checkpoint/Restore", s.str().c_str() );
+        return false;
+    }
+    return true;
+}
+
+void ram::end_of_simulation()
+{
+    if( !mem->sync() )
+        SC_REPORT_WARNING( "RAM/Image", "cannot write back memory image" );
+}
+
+/* check for valid address request of 'words' words starting at addr
+ * returns false, if address is valid,
+ * true (with error report) otherwise
  */
-bool ram::is_invalid_address( unsigned addr ) const
+bool ram::is_invalid_address( unsigned addr, unsigned words ) const
 {
+    if( addr < mem->size() && words <= mem->size() - addr )
+        return false;
+
+    report_invalid_address( addr );
+    return true;
 }
 
 /* helper function to report out-of-range error  */
@@ -26,7 +232,7 @@ void ram::report_invalid_address( unsigned addr ) const
     std::stringstream s;
     s << "Address "  << addr
       << " out of range [" << 0 << ","
-      << mem.size() << ") "
+      << mem->size() << ") "
       << "of RAM "<< name() << " - ignored";
 
     SC_REPORT_WARNING( "RAM/Out of range", s.str().c_str() );
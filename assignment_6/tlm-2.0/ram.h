@@ -3,33 +3,110 @@
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 
-/* FILLME: add other required include files */
-// TODO: add tlm.h as include
+#include <systemc>
+#include <tlm.h>
 
-#include <vector>
+#include "checkpoint.h"
+#include "ram_storage.h"
+#include "stats.h"
 
+// Memory target
+//
+// Addresses are word addresses: address 'a' refers to word 'a' of the
+// backing store, each word holding one 'unsigned'.  This also holds
+// for the DMI ranges handed out by get_direct_mem_ptr, i.e. address
+// 'a' of a DMI region is found at 'dmi_ptr + (a - start) *
+// sizeof(unsigned)'.
+//
+// A transaction of data_length bytes accesses data_length/sizeof(unsigned)
+// consecutive words, starting at its address.  With a streaming width
+// below data_length, the access wraps back to the start address after
+// each streaming_width bytes.  Byte enables apply per byte of data.
+//
+// The backing store defaults to a flat vector of 'size' words.  DMI
+// pointers cover one contiguous block of the backing store, e.g. a
+// single page of a sparse_storage, or the whole image of a
+// mapped_storage.  Blocks not written yet (see
+// ram_storage::placeholder) are granted for reading only, writing them
+// revokes that DMI.
+//
+// Every access takes 'latency'.  Derived targets model other timing by
+// overriding access_time (e.g. banked_ram, see banked_ram.h).  Debug
+// transport accesses the backing store in zero time, for all of them.
+//
+// Checkpoints save the backing store as image '<prefix>.<name>' (see
+// checkpoint.h), restored by mapping it as a mapped_storage; a missing
+// or short image is an error on restore.  The timing state of derived
+// targets (e.g. open rows) is not saved.
 struct ram
   : public sc_core::sc_module
-  /* FILLME: protected inheritance from socket interface */
+  , protected tlm::tlm_fw_transport_if<>
+  , protected checkpointable
 {
     typedef ram                this_type;
     typedef sc_core::sc_module base_type;
 
-    ram( sc_core::sc_module_name, unsigned size );
+    // takes ownership of 'storage', which has to hold 'size' words
+    ram( sc_core::sc_module_name, unsigned size,
+         sc_core::sc_time latency = sc_core::SC_ZERO_TIME,
+         ram_storage* storage = NULL );
+    ~ram();
 
-    //* FILLME: socket definitions */
+    tlm::tlm_target_socket<> target_socket;
+
+protected:
+    // reads or writes the data of 'trans' and sets its response
+    // status; returns the number of words accessed, 0 on errors
+    unsigned access( tlm::tlm_generic_payload& trans );
+
+    // time an access of 'words' words from 'addr' on takes, when it
+    // arrives 'delay' after the current time
+    virtual sc_core::sc_time access_time( unsigned addr, unsigned words,
+                                          bool write,
+                                          const sc_core::sc_time& delay );
+
+    // flush the backing store, e.g. to its image file
+    virtual void end_of_simulation();
+
+    // access time, annotated to the transaction delay
+    sc_core::sc_time latency;
+
+    // hand out DMI pointers, whose accesses bypass access_time
+    bool dmi_enabled;
+
+    // traffic served, see stats.h
+    socket_stats target_stats;
 
 private:
 
     // helper functions
-    bool is_invalid_address( unsigned addr ) const;
+    bool is_invalid_address( unsigned addr, unsigned words = 1 ) const;
+    // the block of the backing store around addr, see ram_storage
+    unsigned* storage_block( unsigned addr, bool write,
+                             unsigned& first, unsigned& last );
     void report_invalid_address( unsigned addr ) const;
 
-    /* FILLME: implement socket interface functions */
-    // TODO: socket interface has multiple things that are inherited, and they need to be implemented in *some* way
+    // tlm_fw_transport_if methods
+    virtual void b_transport( tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    // non-blocking transport, every request completes right away
+    virtual tlm::tlm_sync_enum
+    nb_transport_fw( tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
+                     sc_core::sc_time& delay );
+
+    virtual bool get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                                     tlm::tlm_dmi& dmi );
+
+    // debug transport: the access without time, statistics or trace
+    virtual unsigned int transport_dbg( tlm::tlm_generic_payload& trans );
+
+    // checkpointable methods: the size, and the contents as image
+    virtual bool save_state( state_type& state, const std::string& prefix );
+    virtual bool restore_state( const state_type& state );
 
     // member variables
-    std::vector<unsigned> mem;
+    ram_storage* mem;
 
 }; // ram
 
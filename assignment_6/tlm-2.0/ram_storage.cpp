@@ -0,0 +1,207 @@
+#include "ram_storage.h"
+
+#include <systemc>
+
+#include <algorithm> // std::min
+#include <cerrno>    // errno
+#include <cstdio>    // std::rename, std::remove
+#include <cstring>   // std::strerror
+#include <iostream>  // std::cerr, std::endl
+#include <sstream>   // std::stringstream
+#include <string>    // std::string
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap, msync, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close, ftruncate, lseek, write
+
+namespace {
+
+// words per page of the image files, pages of zeros are not written
+const unsigned image_page = 1024;
+
+bool write_all( int fd, const unsigned* words, unsigned count )
+{
+    const char* data = reinterpret_cast< const char* >( words );
+    std::size_t left = std::size_t( count ) * sizeof(unsigned);
+    while( left ) {
+        ssize_t n = write( fd, data, left );
+        if( n <= 0 )
+            return false;
+        data += n;
+        left -= n;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool save_storage( ram_storage& store, const char* filename )
+{
+    std::string temp = std::string( filename ) + ".tmp";
+    int fd = open( temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 )
+        return false;
+
+    bool     ok   = true;
+    unsigned size = store.size();
+    for( unsigned addr = 0; ok && addr < size; ) {
+        unsigned first, last;
+        const unsigned* words = store.block( addr, false, first, last )
+                              + ( addr - first );
+
+        // page by page within the block
+        unsigned count = std::min( last - addr + 1, image_page );
+        bool     zero  = true;
+        for( unsigned i = 0; zero && i < count; ++i )
+            zero = !words[i];
+
+        if( zero )
+            ok = lseek( fd, off_t( count ) * sizeof(unsigned), SEEK_CUR ) >= 0;
+        else
+            ok = write_all( fd, words, count );
+        addr += count;
+    }
+
+    // trailing holes
+    ok = ok && ftruncate( fd, off_t( size ) * sizeof(unsigned) ) == 0;
+    ok = close( fd ) == 0 && ok;
+    if( ok )
+        ok = std::rename( temp.c_str(), filename ) == 0;
+    if( !ok )
+        std::remove( temp.c_str() );
+    return ok;
+}
+
+flat_storage::flat_storage( unsigned size )
+: mem( size, 0 )
+{}
+
+unsigned* flat_storage::block( unsigned /* addr unused */,
+                               bool /* write unused */,
+                               unsigned& first, unsigned& last )
+{
+    first = 0;
+    last  = mem.size() - 1;
+    return &mem[0];
+}
+
+
+sparse_storage::sparse_storage( unsigned size, unsigned page_bits )
+: words( size )
+, page_bits( page_bits )
+, pages( ( size + ( 1U << page_bits ) - 1 ) >> page_bits, NULL )
+, zero_page( 1U << page_bits, 0 )
+, allocated( 0 )
+{}
+
+sparse_storage::~sparse_storage()
+{
+    for( unsigned i = 0; i < pages.size(); ++i )
+        delete [] pages[i];
+}
+
+unsigned* sparse_storage::block( unsigned addr, bool write,
+                                 unsigned& first, unsigned& last )
+{
+    unsigned*& page = pages[ addr >> page_bits ];
+
+    first = ( addr >> page_bits ) << page_bits;
+    last  = std::min( first + zero_page.size(), std::size_t( words ) ) - 1;
+
+    if( page )
+        return page;
+
+    if( !write )
+        return &zero_page[0];
+
+    page = new unsigned[ zero_page.size() ]();
+    ++allocated;
+    return page;
+}
+
+
+mapped_storage::mapped_storage( const char* filename, unsigned size,
+                                bool shared, bool huge_pages )
+: words( size )
+, bytes( std::size_t( size ) * sizeof(unsigned) )
+, shared( shared )
+, image( false )
+, mem( NULL )
+{
+    // zeros for the whole range first, the file is mapped over it
+    void* base = mmap( NULL, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( base == MAP_FAILED ) {
+        std::stringstream s;
+        s << "cannot allocate " << bytes << " bytes: "
+          << std::strerror( errno );
+        SC_REPORT_ERROR( "RAM/Storage", s.str().c_str() );
+        return;
+    }
+    mem = static_cast< unsigned* >( base );
+
+    int fd = open( filename, shared ? O_RDWR | O_CREAT : O_RDONLY, 0644 );
+    struct stat st;
+    if( fd < 0 || fstat( fd, &st ) < 0 ) {
+        std::cerr << "RAM ERROR: cannot open image " << filename << ": "
+                  << std::strerror( errno ) << " - starting with zeros"
+                  << std::endl;
+        if( fd >= 0 ) close( fd );
+        return;
+    }
+
+    // shared mappings need the whole range in the file
+    std::size_t mapped = std::min( std::size_t( st.st_size ), bytes );
+    if( shared && std::size_t( st.st_size ) < bytes ) {
+        if( ftruncate( fd, bytes ) == 0 )
+            mapped = bytes;
+        else
+            std::cerr << "RAM ERROR: cannot resize image " << filename
+                      << ": " << std::strerror( errno ) << std::endl;
+    }
+
+    if( mapped > 0
+        && mmap( mem, mapped, PROT_READ | PROT_WRITE,
+                 ( shared ? MAP_SHARED : MAP_PRIVATE ) | MAP_FIXED,
+                 fd, 0 ) == MAP_FAILED ) {
+        std::cerr << "RAM ERROR: cannot map image " << filename << ": "
+                  << std::strerror( errno ) << " - starting with zeros"
+                  << std::endl;
+    } else {
+        image = mapped == bytes;
+    }
+    close( fd );
+
+#ifdef MADV_HUGEPAGE
+    // best effort, only honoured where the kernel supports it
+    if( huge_pages )
+        madvise( mem, bytes, MADV_HUGEPAGE );
+#else
+    (void) huge_pages;
+#endif
+}
+
+mapped_storage::~mapped_storage()
+{
+    if( mem )
+        munmap( mem, bytes );
+}
+
+unsigned* mapped_storage::block( unsigned /* addr unused */,
+                                 bool /* write unused */,
+                                 unsigned& first, unsigned& last )
+{
+    first = 0;
+    last  = words - 1;
+    return mem;
+}
+
+bool mapped_storage::sync()
+{
+    if( !shared || !mem )
+        return true;
+    return msync( mem, bytes, MS_SYNC ) == 0;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
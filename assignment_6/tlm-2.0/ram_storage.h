@@ -0,0 +1,120 @@
+#ifndef RAM_STORAGE_H_INCLUDED_
+#define RAM_STORAGE_H_INCLUDED_
+
+#include <cstddef>
+#include <vector>
+
+// Backing store of a ram, word addressed (see ram.h)
+struct ram_storage
+{
+    virtual ~ram_storage() {}
+
+    // number of words
+    virtual unsigned size() const = 0;
+
+    // contiguous block of words containing addr: returns a pointer to
+    // the first word of the block and sets its first and last address.
+    // The block may only be written to if 'write' is set.
+    virtual unsigned* block( unsigned addr, bool write,
+                             unsigned& first, unsigned& last ) = 0;
+
+    // make the contents persistent, if the store has a backing file
+    virtual bool sync() { return true; }
+
+    // true if the block around addr is shared by words not written
+    // yet, replaced by the first write (e.g. the zero page of a
+    // sparse_storage)
+    virtual bool placeholder( unsigned /* addr unused */ ) const
+    { return false; }
+
+    // true if all words were mapped from an image file
+    virtual bool from_image() const { return false; }
+};
+
+// writes the words of 'store' to the image file 'filename' (see
+// mapped_storage), pages of zeros become holes; the file is replaced
+// rather than rewritten, so mappings of the old one stay intact
+bool save_storage( ram_storage& store, const char* filename );
+
+// all words in a single vector, allocated up front
+struct flat_storage
+: public ram_storage
+{
+    explicit flat_storage( unsigned size );
+
+    virtual unsigned size() const
+    { return mem.size(); }
+
+    virtual unsigned* block( unsigned addr, bool write,
+                             unsigned& first, unsigned& last );
+
+private:
+    std::vector<unsigned> mem;
+};
+
+// pages of 2^page_bits words, allocated on first write; pages never
+// written to read as zero
+struct sparse_storage
+: public ram_storage
+{
+    explicit sparse_storage( unsigned size, unsigned page_bits = 10 );
+    ~sparse_storage();
+
+    virtual unsigned size() const
+    { return words; }
+
+    virtual unsigned* block( unsigned addr, bool write,
+                             unsigned& first, unsigned& last );
+
+    virtual bool placeholder( unsigned addr ) const
+    { return !pages[ addr >> page_bits ]; }
+
+    unsigned long allocated_pages() const
+    { return allocated; }
+
+private:
+    unsigned words;
+    unsigned page_bits;
+
+    // flat page table, NULL for untouched pages
+    std::vector<unsigned*> pages;
+    // shared by all untouched pages
+    std::vector<unsigned>  zero_page;
+
+    unsigned long allocated;
+};
+
+// words mapped from an image file, so loading costs nothing up front.
+// Shared mappings write through to the file (made durable by sync()),
+// private ones are copy-on-write and leave the file untouched.  Files
+// shorter than 'size' words are padded with zeros.  Failing to
+// allocate the range is an error (SC_REPORT_ERROR).
+struct mapped_storage
+: public ram_storage
+{
+    mapped_storage( const char* filename, unsigned size,
+                    bool shared = false, bool huge_pages = false );
+    ~mapped_storage();
+
+    virtual unsigned size() const
+    { return words; }
+
+    virtual unsigned* block( unsigned addr, bool write,
+                             unsigned& first, unsigned& last );
+
+    virtual bool sync();
+
+    virtual bool from_image() const
+    { return image; }
+
+private:
+    unsigned    words;
+    std::size_t bytes;
+    bool        shared;
+    bool        image;
+    unsigned*   mem;
+};
+
+#endif // RAM_STORAGE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,104 @@
+
+#include "replayer.h"
+#include "capture_file.h"
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cstring>  // std::memcmp
+#include <iostream> // std::cout, std::endl
+#include <sstream>  // std::stringstream
+
+replayer::replayer( sc_core::sc_module_name /* unused */,
+                    const char* filename, bool timed )
+: base_type()
+, init_socket( "init_socket" )
+, filename( filename )
+, timed( timed )
+, qk()
+, buffer()
+, transactions(), errors(), mismatches()
+, started(), finished(), wall()
+{
+    SC_THREAD( action );
+    init_socket.bind( *this );
+}
+
+void replayer::action()
+{
+    capture::reader in;
+    if( !in.open( filename.c_str() ) ) {
+        std::stringstream s;
+        s << "cannot read capture " << filename;
+        SC_REPORT_ERROR( "Replay/File", s.str().c_str() );
+        return;
+    }
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point wall_start = clock::now();
+
+    qk.reset();
+    started = qk.get_current_time();
+
+    tlm::tlm_generic_payload trans;
+    capture::record          r;
+    bool                     first = true;
+    std::uint64_t            first_time = 0;
+
+    while( in.next( r ) ) {
+        if( timed ) {
+            if( first )
+                first_time = r.time;
+            sc_core::sc_time due = started
+                + sc_core::sc_time( double( r.time - first_time ), sc_core::SC_PS );
+            if( qk.get_current_time() < due )
+                qk.inc( due - qk.get_current_time() );
+        }
+        first = false;
+
+        tlm::tlm_command command = tlm::tlm_command( r.command );
+        unsigned char*   data;
+        if( command == tlm::TLM_WRITE_COMMAND && r.data ) {
+            // targets only read the data of writes
+            data = const_cast< unsigned char* >( r.data );
+        } else {
+            buffer.assign( r.length, 0 );
+            data = buffer.empty() ? NULL : &buffer[0];
+        }
+
+        trans.set_command( command );
+        trans.set_address( r.address );
+        trans.set_data_ptr( data );
+        trans.set_data_length( r.length );
+        trans.set_streaming_width( r.length );
+        trans.set_byte_enable_ptr( NULL );
+        trans.set_dmi_allowed( false );
+        trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        init_socket->b_transport( trans, delay );
+        ++transactions;
+
+        if( trans.is_response_error() )
+            ++errors;
+        else if( command == tlm::TLM_READ_COMMAND && r.data
+                 && std::memcmp( data, r.data, r.length ) )
+            ++mismatches;
+
+        qk.inc( delay );
+        if( qk.need_sync() )
+            qk.sync();
+    }
+
+    qk.sync();
+    finished = sc_core::sc_time_stamp();
+    wall = std::chrono::duration<double>( clock::now() - wall_start ).count();
+}
+
+void replayer::end_of_simulation()
+{
+    std::cout << name() << ": " << transactions << " transactions replayed"
+              << " in " << finished - started << " (" << wall << " s), "
+              << errors << " errors, " << mismatches
+              << " reads differing from the capture" << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
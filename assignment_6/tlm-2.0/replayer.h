@@ -0,0 +1,67 @@
+#ifndef REPLAYER_H_INCLUDED_
+#define REPLAYER_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+
+#include <string>
+#include <vector>
+
+// Replays a capture (see monitor.h) as fast as possible
+//
+// The capture is streamed from a read-only memory mapping, write data
+// is passed to the target straight from it.  With 'timed' set, every
+// transaction is issued at its recorded time relative to the first
+// one (or as soon as possible, when running behind), otherwise they
+// follow each other back to back.  Read data differing from the
+// capture is counted.
+struct replayer
+: public sc_core::sc_module
+, protected tlm::tlm_bw_transport_if<>
+{
+    typedef replayer           this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+    replayer( sc_core::sc_module_name, const char* filename,
+              bool timed = false );
+
+    tlm::tlm_initiator_socket<> init_socket;
+
+private:
+    void action();
+
+    virtual void end_of_simulation();
+
+    // tlm_bw_transport_if methods, not used
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( tlm::tlm_generic_payload&, tlm::tlm_phase&,
+                     sc_core::sc_time& )
+    { return tlm::TLM_COMPLETED; }
+
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64, sc_dt::uint64 )
+    {}
+
+    // member variables
+    std::string filename;
+    bool        timed;
+
+    // local time for temporal decoupling
+    tlm_utils::tlm_quantumkeeper qk;
+
+    // data of read transactions
+    std::vector<unsigned char> buffer;
+
+    // statistics
+    unsigned long    transactions;
+    unsigned long    errors;
+    unsigned long    mismatches;
+    sc_core::sc_time started;
+    sc_core::sc_time finished;
+    double           wall; // s
+}; // replayer
+
+#endif // REPLAYER_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -1,13 +1,104 @@
 #include "router.h"
+#include "debug_transport.h"
+#include "tracer.h"
 
-// FILLME: implement router::b_transport
-//   NOTE: You can use 'targets.decode()' from the address_map class for
-//         the actual decoding.  'address_map::npos' is returned, if the
-//         requested address is not mapped.
-//         Keep in mind to translate the address to the target address space
-//         and reset it before return.
+#include <iostream> // std::cout, std::endl
 
-// FILLME: implement router::end_of_elaboration
-//         setup the targets from the memory map file
-//         (as in the bus implementation)
+router::router( sc_core::sc_module_name /* unused */, const char* mem_map )
+: base_type()
+, init_socket("init_socket")
+, target_socket("target_socket")
+, mem_map( mem_map )
+{
+    target_socket.register_b_transport(this, &this_type::b_transport);
+    target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+    target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+    init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
+}
 
+void router::b_transport( tlm::tlm_generic_payload& trans,
+                          sc_core::sc_time& delay )
+{
+    stats_scope initiator( target_stats, trans, delay );
+    trace_scope hop( *this, "route", trans, delay );
+
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = decoded.decode( targets, addr );
+
+    if( target == address_map::npos ) {
+        trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+        return;
+    }
+    stats_scope slave( init_stats[target], trans, delay );
+
+    // translate to the target address space and reset it afterwards
+    trans.set_address( decoded.get_local_address( addr ) );
+    init_socket[target]->b_transport( trans, delay );
+    trans.set_address( addr );
+}
+
+bool router::get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                                 tlm::tlm_dmi& dmi )
+{
+    address_map::address_type addr = trans.get_address();
+    address_map::index_type target = decoded.decode( targets, addr );
+
+    if( target == address_map::npos )
+        return false;
+
+    trans.set_address( decoded.get_local_address( addr ) );
+    bool granted = init_socket[target]->get_direct_mem_ptr( trans, dmi );
+    trans.set_address( addr );
+
+    // translate the region back to the global address space
+    address_map::address_type start = dmi.get_start_address();
+    address_map::address_type end   = dmi.get_end_address();
+    targets.get_global_range( target, start, end );
+    dmi.set_start_address( start );
+    dmi.set_end_address( end );
+
+    return granted;
+}
+
+void router::invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                        sc_dt::uint64 end )
+{
+    address_map::address_type global_start = start;
+    address_map::address_type global_end   = end;
+    targets.get_global_range( id, global_start, global_end );
+
+    target_socket->invalidate_direct_mem_ptr( global_start, global_end );
+}
+
+unsigned int router::transport_dbg( tlm::tlm_generic_payload& trans )
+{
+    // the decode cache is left alone
+    return route_dbg( targets, trans,
+        [this]( address_map::index_type target, tlm::tlm_generic_payload& t )
+        { return init_socket[target]->transport_dbg( t ); } );
+}
+
+// setup the targets from the memory map file
+void router::end_of_elaboration()
+{
+    address_map( init_socket.size(), mem_map.c_str() ).swap( targets );
+
+    sc_assert( init_socket.size() == targets.size() );
+
+    decoded.invalidate();
+
+    init_stats.resize( init_socket.size() );
+    register_stats( *this, "target_socket", target_stats );
+    for( unsigned i = 0; i < init_stats.size(); ++i )
+        register_stats( *this, "init_socket", init_stats[i], i );
+}
+
+void router::end_of_simulation()
+{
+    std::cout << name() << " decode cache: "
+              << decoded.hits << " hits, "
+              << decoded.misses << " misses"
+              << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -2,6 +2,10 @@
 #define ROUTER_H_INCLUDED_
 
 #include "address_map.h"
+#include "decode_cache.h"
+#include "stats.h"
+
+#include <string>
 
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 #include <systemc>
@@ -10,7 +14,48 @@
 #include <tlm_utils/multi_passthrough_initiator_socket.h>
 #include <tlm_utils/simple_target_socket.h>
 
-// FILLME: implement router module, starting from bus (PV) module
+// Routing component: connects a single master to all slaves
+struct router
+: public sc_core::sc_module
+{
+    typedef router             this_type;
+    typedef sc_core::sc_module base_type;
+
+    tlm_utils::multi_passthrough_initiator_socket<this_type> init_socket;
+    tlm_utils::simple_target_socket<this_type>               target_socket;
+
+    router( sc_core::sc_module_name = sc_core::sc_gen_unique_name("router"),
+            const char* mem_map = "mem_map.txt" );
+
+private:
+    // Loosely-Timed (Blocking Transport)
+    virtual void b_transport( tlm::tlm_generic_payload& trans,
+                              sc_core::sc_time& delay );
+
+    // Direct Memory Interface
+    virtual bool get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                                     tlm::tlm_dmi& dmi );
+    virtual void invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    // Debug transport, in zero time (see debug_transport.h)
+    virtual unsigned int transport_dbg( tlm::tlm_generic_payload& trans );
+
+    // stuff for address decoding
+    virtual void end_of_elaboration();
+    virtual void end_of_simulation();
+
+    std::string mem_map;
+    address_map targets;
+
+    // last decoded region of our master
+    decode_cache decoded;
+
+    // traffic of our master and per target, see stats.h
+    socket_stats              target_stats;
+    std::vector<socket_stats> init_stats;
+};
 
 #endif // ROUTER_H_INCLUDED_
 
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,583 @@
+#include "rv32_iss.h"
+#include "tracer.h"
+
+#include <chrono>   // std::chrono::steady_clock
+#include <cstring>  // std::memcpy
+#include <iostream> // std::cout, std::endl
+#include <sstream>  // std::stringstream
+
+// execution of the decoded operations, a friend of rv32_iss
+struct rv32_exec
+{
+    typedef rv32_iss::op op;
+
+    // fills in the operation from the instruction at its pc, then
+    // executes it
+    static op* decode( rv32_iss& c, op* o );
+
+    // continues on the next page
+    static op* page_end( rv32_iss& c, op* o )
+    {
+        op* next = c.lookup( o->pc );
+        return next ? next : o;
+    }
+
+    static op* illegal( rv32_iss& c, op* o )
+    { return c.stop( o, "illegal instruction" ); }
+
+    static op* nop( rv32_iss&, op* o )
+    { return o + 1; }
+
+    static op* lui( rv32_iss& c, op* o )
+    {
+        c.x[o->rd] = o->imm;
+        return o + 1;
+    }
+
+    static op* auipc( rv32_iss& c, op* o )
+    {
+        c.x[o->rd] = o->pc + o->imm;
+        return o + 1;
+    }
+
+    static op* taken( rv32_iss& c, op* o )
+    {
+        if( !o->target ) {
+            o->target = c.lookup( o->pc + o->imm );
+            if( !o->target )
+                return o;
+        }
+        return o->target;
+    }
+
+    static op* jal( rv32_iss& c, op* o )
+    {
+        c.x[o->rd] = o->pc + 4;
+        return taken( c, o );
+    }
+
+    static op* jalr( rv32_iss& c, op* o )
+    {
+        std::uint32_t to = ( c.x[o->rs1] + o->imm ) & ~1u;
+        c.x[o->rd] = o->pc + 4;
+        op* next = c.lookup( to );
+        return next ? next : o;
+    }
+
+    template< bool (*Condition)( std::uint32_t, std::uint32_t ) >
+    static op* branch( rv32_iss& c, op* o )
+    {
+        if( Condition( c.x[o->rs1], c.x[o->rs2] ) )
+            return taken( c, o );
+        return o + 1;
+    }
+
+    template< unsigned Size, bool Signed >
+    static op* load( rv32_iss& c, op* o )
+    {
+        std::uint32_t addr = c.x[o->rs1] + o->imm;
+        std::uint32_t word;
+        if( addr % Size )
+            return c.stop( o, "misaligned load" );
+        if( !c.read_word( addr & ~3u, word ) )
+            return o;
+
+        // little endian: byte 'i' of a word are its bits 8*i and up
+        word >>= 8 * ( addr & 3 );
+        if( Size < 4 ) {
+            word &= std::uint32_t( ( 1ull << 8 * Size ) - 1 );
+            if( Signed && ( word >> ( 8 * Size - 1 ) ) )
+                word |= std::uint32_t( ~0ull << 8 * Size );
+        }
+        c.x[o->rd] = word;
+        ++c.loads;
+        return o + 1;
+    }
+
+    template< unsigned Size >
+    static op* store( rv32_iss& c, op* o )
+    {
+        std::uint32_t addr  = c.x[o->rs1] + o->imm;
+        unsigned      shift = 8 * ( addr & 3 );
+        if( addr % Size )
+            return c.stop( o, "misaligned store" );
+
+        std::uint32_t mask = std::uint32_t( ( 1ull << 8 * Size ) - 1 ) << shift;
+        if( !c.write_word( addr & ~3u, c.x[o->rs2] << shift, mask ) )
+            return o;
+        ++c.stores;
+        return o + 1;
+    }
+
+    template< std::uint32_t (*Function)( std::uint32_t, std::uint32_t ) >
+    static op* alu( rv32_iss& c, op* o )
+    {
+        c.x[o->rd] = Function( c.x[o->rs1], c.x[o->rs2] );
+        return o + 1;
+    }
+
+    template< std::uint32_t (*Function)( std::uint32_t, std::uint32_t ) >
+    static op* alu_imm( rv32_iss& c, op* o )
+    {
+        c.x[o->rd] = Function( c.x[o->rs1], o->imm );
+        return o + 1;
+    }
+
+    // counters, read with csrrs rd, csr, x0
+    static op* counter( rv32_iss& c, op* o )
+    {
+        std::uint64_t retired = c.instructions + c.executed;
+        std::uint64_t value;
+        switch( o->imm & 0x7f ) {
+        case 0x00: // cycle
+            value = std::uint64_t( ( c.qk.get_current_time() + c.local_time() )
+                                   / c.cycle );
+            break;
+        case 0x01: // time, in ns
+            value = std::uint64_t( ( c.qk.get_current_time() + c.local_time() )
+                                   .to_seconds() * 1e9 );
+            break;
+        default:   // instret
+            value = retired;
+            break;
+        }
+        c.x[o->rd] = std::uint32_t( o->imm & 0x80 ? value >> 32 : value );
+        return o + 1;
+    }
+
+    static op* ecall( rv32_iss& c, op* o )
+    {
+        // exit( a0 )
+        if( c.x[17] != 93 )
+            return c.stop( o, "unsupported system call" );
+        c.exit_code = int( c.x[10] );
+        return c.stop( o, NULL );
+    }
+
+    static op* ebreak( rv32_iss& c, op* o )
+    { return c.stop( o, NULL ); }
+
+    // the functions of the ALU
+    static std::uint32_t add( std::uint32_t a, std::uint32_t b )  { return a + b; }
+    static std::uint32_t sub( std::uint32_t a, std::uint32_t b )  { return a - b; }
+    static std::uint32_t sll( std::uint32_t a, std::uint32_t b )  { return a << ( b & 31 ); }
+    static std::uint32_t srl( std::uint32_t a, std::uint32_t b )  { return a >> ( b & 31 ); }
+    static std::uint32_t sra( std::uint32_t a, std::uint32_t b )
+    { return std::uint32_t( std::int32_t( a ) >> ( b & 31 ) ); }
+    static std::uint32_t slt( std::uint32_t a, std::uint32_t b )
+    { return std::int32_t( a ) < std::int32_t( b ); }
+    static std::uint32_t sltu( std::uint32_t a, std::uint32_t b ) { return a < b; }
+    static std::uint32_t bit_xor( std::uint32_t a, std::uint32_t b ) { return a ^ b; }
+    static std::uint32_t bit_or( std::uint32_t a, std::uint32_t b )  { return a | b; }
+    static std::uint32_t bit_and( std::uint32_t a, std::uint32_t b ) { return a & b; }
+
+    static std::uint32_t mul( std::uint32_t a, std::uint32_t b )  { return a * b; }
+    static std::uint32_t mulh( std::uint32_t a, std::uint32_t b )
+    {
+        return std::uint32_t( ( std::int64_t( std::int32_t( a ) )
+                                * std::int64_t( std::int32_t( b ) ) ) >> 32 );
+    }
+    static std::uint32_t mulhsu( std::uint32_t a, std::uint32_t b )
+    {
+        return std::uint32_t( ( std::int64_t( std::int32_t( a ) )
+                                * std::int64_t( b ) ) >> 32 );
+    }
+    static std::uint32_t mulhu( std::uint32_t a, std::uint32_t b )
+    { return std::uint32_t( ( std::uint64_t( a ) * b ) >> 32 ); }
+
+    // division by zero and overflow do not trap
+    static std::uint32_t div( std::uint32_t a, std::uint32_t b )
+    {
+        if( !b )
+            return ~0u;
+        if( a == 0x80000000u && b == ~0u )
+            return a;
+        return std::uint32_t( std::int32_t( a ) / std::int32_t( b ) );
+    }
+    static std::uint32_t divu( std::uint32_t a, std::uint32_t b )
+    { return b ? a / b : ~0u; }
+    static std::uint32_t rem( std::uint32_t a, std::uint32_t b )
+    {
+        if( !b )
+            return a;
+        if( a == 0x80000000u && b == ~0u )
+            return 0;
+        return std::uint32_t( std::int32_t( a ) % std::int32_t( b ) );
+    }
+    static std::uint32_t remu( std::uint32_t a, std::uint32_t b )
+    { return b ? a % b : a; }
+
+    // the conditions of the branches
+    static bool eq( std::uint32_t a, std::uint32_t b )  { return a == b; }
+    static bool ne( std::uint32_t a, std::uint32_t b )  { return a != b; }
+    static bool lt( std::uint32_t a, std::uint32_t b )
+    { return std::int32_t( a ) < std::int32_t( b ); }
+    static bool ge( std::uint32_t a, std::uint32_t b )
+    { return std::int32_t( a ) >= std::int32_t( b ); }
+    static bool ltu( std::uint32_t a, std::uint32_t b ) { return a < b; }
+    static bool geu( std::uint32_t a, std::uint32_t b ) { return a >= b; }
+};
+
+rv32_exec::op* rv32_exec::decode( rv32_iss& c, op* o )
+{
+    std::uint32_t inst;
+    if( !c.read_word( o->pc, inst ) )
+        return o;
+    ++c.decodes;
+
+    unsigned funct3 = ( inst >> 12 ) & 7;
+    unsigned funct7 = inst >> 25;
+    unsigned rd     = ( inst >> 7 ) & 31;
+
+    o->rd     = rd ? rd : 32;
+    o->rs1    = ( inst >> 15 ) & 31;
+    o->rs2    = ( inst >> 20 ) & 31;
+    o->imm    = std::int32_t( inst ) >> 20; // I-type
+    o->target = NULL;
+    o->exec   = &illegal;
+
+    switch( inst & 0x7f ) {
+    case 0x37: // lui
+        o->imm  = std::int32_t( inst & 0xfffff000u );
+        o->exec = &lui;
+        break;
+
+    case 0x17: // auipc
+        o->imm  = std::int32_t( inst & 0xfffff000u );
+        o->exec = &auipc;
+        break;
+
+    case 0x6f: // jal
+        o->imm  = ( ( std::int32_t( inst ) >> 31 ) << 20 )
+                | ( inst & 0x000ff000u )
+                | ( ( inst >> 9 ) & 0x800 )
+                | ( ( inst >> 20 ) & 0x7fe );
+        o->exec = &jal;
+        break;
+
+    case 0x67: // jalr
+        if( funct3 == 0 )
+            o->exec = &jalr;
+        break;
+
+    case 0x63: // branches
+        o->imm  = ( ( std::int32_t( inst ) >> 31 ) << 12 )
+                | ( ( inst << 4 ) & 0x800 )
+                | ( ( inst >> 20 ) & 0x7e0 )
+                | ( ( inst >> 7 ) & 0x1e );
+        switch( funct3 ) {
+        case 0: o->exec = &branch<eq>;  break;
+        case 1: o->exec = &branch<ne>;  break;
+        case 4: o->exec = &branch<lt>;  break;
+        case 5: o->exec = &branch<ge>;  break;
+        case 6: o->exec = &branch<ltu>; break;
+        case 7: o->exec = &branch<geu>; break;
+        }
+        break;
+
+    case 0x03: // loads
+        switch( funct3 ) {
+        case 0: o->exec = &load<1,true>;  break;
+        case 1: o->exec = &load<2,true>;  break;
+        case 2: o->exec = &load<4,false>; break;
+        case 4: o->exec = &load<1,false>; break;
+        case 5: o->exec = &load<2,false>; break;
+        }
+        break;
+
+    case 0x23: // stores
+        o->imm = ( ( std::int32_t( inst ) >> 25 ) << 5 ) | ( ( inst >> 7 ) & 31 );
+        switch( funct3 ) {
+        case 0: o->exec = &store<1>; break;
+        case 1: o->exec = &store<2>; break;
+        case 2: o->exec = &store<4>; break;
+        }
+        break;
+
+    case 0x13: // register-immediate
+        switch( funct3 ) {
+        case 0: o->exec = &alu_imm<add>;     break;
+        case 2: o->exec = &alu_imm<slt>;     break;
+        case 3: o->exec = &alu_imm<sltu>;    break;
+        case 4: o->exec = &alu_imm<bit_xor>; break;
+        case 6: o->exec = &alu_imm<bit_or>;  break;
+        case 7: o->exec = &alu_imm<bit_and>; break;
+        case 1:
+            if( funct7 == 0 )
+                o->exec = &alu_imm<sll>;
+            o->imm = o->rs2;
+            break;
+        case 5:
+            if( funct7 == 0 )
+                o->exec = &alu_imm<srl>;
+            else if( funct7 == 0x20 )
+                o->exec = &alu_imm<sra>;
+            o->imm = o->rs2;
+            break;
+        }
+        break;
+
+    case 0x33: // register-register
+        if( funct7 == 0 ) {
+            static const rv32_iss::handler base[8] = {
+                &alu<add>, &alu<sll>, &alu<slt>, &alu<sltu>,
+                &alu<bit_xor>, &alu<srl>, &alu<bit_or>, &alu<bit_and>
+            };
+            o->exec = base[funct3];
+        } else if( funct7 == 0x20 && funct3 == 0 ) {
+            o->exec = &alu<sub>;
+        } else if( funct7 == 0x20 && funct3 == 5 ) {
+            o->exec = &alu<sra>;
+        } else if( funct7 == 1 ) {
+            static const rv32_iss::handler muldiv[8] = {
+                &alu<mul>, &alu<mulh>, &alu<mulhsu>, &alu<mulhu>,
+                &alu<div>, &alu<divu>, &alu<rem>, &alu<remu>
+            };
+            o->exec = muldiv[funct3];
+        }
+        break;
+
+    case 0x0f: // fence, fence.i: stores drop stale decodings anyway
+        o->exec = &nop;
+        break;
+
+    case 0x73: // system
+        if( inst == 0x00000073u ) {
+            o->exec = &ecall;
+        } else if( inst == 0x00100073u ) {
+            o->exec = &ebreak;
+        } else if( funct3 == 2 && o->rs1 == 0 ) {
+            // csrrs rd, csr, x0 of cycle, time, instret and their
+            // upper halves
+            std::uint32_t csr = ( inst >> 20 ) & 0xfff;
+            if( ( csr & ~0x80u ) >= 0xc00 && ( csr & ~0x80u ) <= 0xc02 ) {
+                o->imm  = csr & 0xff;
+                o->exec = &counter;
+            }
+        }
+        break;
+    }
+
+    return o->exec( c, o );
+}
+
+rv32_iss::rv32_iss( sc_core::sc_module_name /* unused */,
+                    std::uint32_t entry, bool use_dmi,
+                    sc_core::sc_time cycle )
+: base_type()
+, init_socket( "init_socket" )
+, entry( entry )
+, use_dmi( use_dmi )
+, cycle( cycle )
+, x()
+, pages()
+, decoded( std::size_t( 1 ) << ( 32 - page_bits ) )
+, budget()
+, executed()
+, stall()
+, halted()
+, dmi_regions()
+, qk()
+, instructions(), decodes(), loads(), stores(), transactions()
+, exit_code()
+, wall()
+{
+    SC_THREAD( run );
+    init_socket.bind( *this );
+}
+
+void rv32_iss::run()
+{
+    typedef std::chrono::steady_clock clock;
+    clock::time_point wall_start = clock::now();
+
+    qk.reset();
+    op* o = lookup( entry );
+
+    while( o && !halted ) {
+        // the rest of the quantum, at least one instruction
+        sc_core::sc_time quantum = tlm::tlm_global_quantum::instance().get();
+        sc_core::sc_time local   = qk.get_local_time();
+        budget = quantum > local ? (unsigned long)( ( quantum - local ) / cycle ) : 0;
+        if( !budget )
+            budget = 1;
+
+        executed = 0;
+        stall    = sc_core::SC_ZERO_TIME;
+        while( executed < budget ) {
+            o = o->exec( *this, o );
+            ++executed;
+        }
+        instructions += executed;
+
+        qk.inc( local_time() );
+        executed = 0;
+        stall    = sc_core::SC_ZERO_TIME;
+        if( qk.need_sync() )
+            qk.sync();
+    }
+
+    qk.sync();
+    wall = std::chrono::duration<double>( clock::now() - wall_start ).count();
+}
+
+rv32_iss::op* rv32_iss::lookup( std::uint32_t pc )
+{
+    if( pc % 4 ) {
+        std::stringstream s;
+        s << "misaligned jump to 0x" << std::hex << pc;
+        stop( NULL, s.str().c_str() );
+        return NULL;
+    }
+
+    std::uint32_t    page = pc >> page_bits;
+    std::vector<op>& ops  = pages[page];
+    if( ops.empty() ) {
+        // decoded when first executed, the last one leads to the
+        // next page
+        ops.resize( page_ops + 1 );
+        for( unsigned i = 0; i <= page_ops; ++i ) {
+            ops[i].exec   = &rv32_exec::decode;
+            ops[i].pc     = ( page << page_bits ) + 4 * i;
+            ops[i].target = NULL;
+        }
+        ops[page_ops].exec = &rv32_exec::page_end;
+        decoded[page] = true;
+    }
+    return &ops[ ( pc >> 2 ) & ( page_ops - 1 ) ];
+}
+
+rv32_iss::op* rv32_iss::stop( op* self, const char* why )
+{
+    halted = true;
+    budget = 0;
+
+    if( why ) {
+        std::stringstream s;
+        s << why;
+        if( self )
+            s << " at pc 0x" << std::hex << self->pc;
+        SC_REPORT_WARNING( "ISS/Stop", s.str().c_str() );
+    }
+    return self;
+}
+
+bool rv32_iss::read_word( std::uint32_t addr, std::uint32_t& value )
+{
+    sc_dt::uint64 word = addr >> 2;
+    if( const tlm::tlm_dmi* dmi = use_dmi ? dmi_regions.find( word, word, false ) : NULL ) {
+        value = reinterpret_cast< const unsigned* >( dmi->get_dmi_ptr() )
+                    [ word - dmi->get_start_address() ];
+        stall += dmi->get_read_latency();
+        return true;
+    }
+    return transport( tlm::TLM_READ_COMMAND, addr, value, ~0u );
+}
+
+bool rv32_iss::write_word( std::uint32_t addr, std::uint32_t value,
+                           std::uint32_t mask )
+{
+    sc_dt::uint64 word = addr >> 2;
+    if( const tlm::tlm_dmi* dmi = use_dmi ? dmi_regions.find( word, word, true ) : NULL ) {
+        unsigned& w = reinterpret_cast< unsigned* >( dmi->get_dmi_ptr() )
+                          [ word - dmi->get_start_address() ];
+        w = ( w & ~mask ) | ( value & mask );
+        stall += dmi->get_write_latency();
+    } else if( !transport( tlm::TLM_WRITE_COMMAND, addr, value, mask ) ) {
+        return false;
+    }
+
+    // the instruction there is decoded again when executed
+    std::uint32_t page = addr >> page_bits;
+    if( decoded[page] )
+        pages[page][ word & ( page_ops - 1 ) ].exec = &rv32_exec::decode;
+    return true;
+}
+
+bool rv32_iss::transport( tlm::tlm_command command, std::uint32_t addr,
+                          std::uint32_t& value, std::uint32_t mask )
+{
+    unsigned      data = value;
+    unsigned char enables[ sizeof(unsigned) ];
+
+    tlm::tlm_generic_payload trans;
+    trans.set_command( command );
+    trans.set_address( addr >> 2 );
+    trans.set_data_ptr( reinterpret_cast< unsigned char* >( &data ) );
+    trans.set_data_length( sizeof(unsigned) );
+    trans.set_streaming_width( sizeof(unsigned) );
+    trans.set_byte_enable_ptr( NULL );
+    trans.set_dmi_allowed( false );
+    trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+    // the bytes of the mask in host order are the enabled ones
+    if( mask != ~0u ) {
+        unsigned m = mask;
+        std::memcpy( enables, &m, sizeof(unsigned) );
+        for( unsigned i = 0; i < sizeof(unsigned); ++i )
+            enables[i] = enables[i] ? tlm::TLM_BYTE_ENABLED
+                                    : tlm::TLM_BYTE_DISABLED;
+        trans.set_byte_enable_ptr( enables );
+        trans.set_byte_enable_length( sizeof(unsigned) );
+    }
+
+    // the stall is measured against the kernel's time, a target may
+    // wait and hand back a delay relative to the time then
+    sc_core::sc_time before = sc_core::sc_time_stamp();
+    sc_core::sc_time delay  = qk.get_local_time() + local_time();
+    sc_core::sc_time issued = before + delay;
+    {
+        trace_scope scope( *this, "transaction", trans, delay, true );
+        init_socket->b_transport( trans, delay );
+    }
+    if( sc_core::sc_time_stamp() != before ) {
+        // the target synchronized, the kernel's time covers the batch
+        // so far
+        instructions += executed;
+        budget       -= executed;
+        executed      = 0;
+        stall         = sc_core::SC_ZERO_TIME;
+        qk.set( delay );
+    } else if( sc_core::sc_time_stamp() + delay > issued ) {
+        stall += sc_core::sc_time_stamp() + delay - issued;
+    }
+    ++transactions;
+
+    if( trans.is_response_error() ) {
+        std::stringstream s;
+        s << trans.get_response_string() << " at address 0x"
+          << std::hex << addr;
+        stop( NULL, s.str().c_str() );
+        return false;
+    }
+
+    if( command == tlm::TLM_READ_COMMAND )
+        value = data;
+    if( use_dmi && trans.is_dmi_allowed() )
+        dmi_regions.request( init_socket, addr >> 2,
+                             command == tlm::TLM_WRITE_COMMAND );
+    return true;
+}
+
+void rv32_iss::invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                          sc_dt::uint64 end )
+{
+    dmi_regions.invalidate( start, end );
+}
+
+void rv32_iss::end_of_simulation()
+{
+    std::cout << name() << ": " << instructions << " instructions, "
+              << decodes << " decoded, " << loads << " loads, "
+              << stores << " stores, " << transactions
+              << " transactions (the rest through DMI)";
+    if( halted )
+        std::cout << ", exit code " << exit_code;
+    std::cout << std::endl;
+
+    if( wall > 0 )
+        std::cout << name() << ": " << wall << " s wall clock, "
+                  << instructions / wall / 1e6 << " MIPS" << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,133 @@
+#ifndef RV32_ISS_H_INCLUDED_
+#define RV32_ISS_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+
+#include "dmi_cache.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Instruction-set simulator of a RISC-V RV32IM core, as an LT initiator
+//
+// Instructions are decoded once, into pages of 1024 decoded
+// operations keyed by their PC, and executed by call threading: the
+// handler of an operation returns the next one, so straight-line code
+// runs without looking at the PC, and branches remember their decoded
+// targets.  A store to a decoded instruction drops its decoding.
+//
+// Fetches, loads and stores use DMI where the targets grant it, and
+// b_transport otherwise.  ISS byte address 'a' is word 'a / 4' of the
+// platform (see ram.h); words are RISC-V little endian values, bytes
+// and halfwords are parts of them.  Misaligned accesses stop the core.
+//
+// Every instruction takes 'cycle', transaction delays stall the core.
+// It runs in batches of one global quantum (at least one instruction),
+// starting at 'entry' with all registers zero; the software sets up its
+// stack (see firmware/start.S).  It stops at 'ecall' with a7 = 93
+// (exit, the code in a0), at 'ebreak', and on illegal instructions.
+// The cycle, time and instret counters can be read.
+struct rv32_iss
+: public sc_core::sc_module
+, protected tlm::tlm_bw_transport_if<>
+{
+    typedef rv32_iss           this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+    rv32_iss( sc_core::sc_module_name, std::uint32_t entry = 0,
+              bool use_dmi = true,
+              sc_core::sc_time cycle = sc_core::sc_time( 1, sc_core::SC_NS ) );
+
+    tlm::tlm_initiator_socket<> init_socket;
+
+private:
+    friend struct rv32_exec;
+
+    struct op;
+    typedef op* ( *handler )( rv32_iss& cpu, op* self );
+
+    // a decoded instruction
+    struct op
+    {
+        handler       exec;
+        std::uint8_t  rd;     // 32 for x0, writes there are dropped
+        std::uint8_t  rs1;
+        std::uint8_t  rs2;
+        std::int32_t  imm;
+        std::uint32_t pc;
+        op*           target; // of a branch or jal, once known
+    };
+
+    static const unsigned page_bits = 12;
+    static const unsigned page_ops  = 1u << ( page_bits - 2 );
+
+    void run();
+
+    // decoded operation at 'pc', NULL (and stopped) if misaligned
+    op* lookup( std::uint32_t pc );
+
+    // stops the core after the current instruction
+    op* stop( op* self, const char* why );
+
+    // word at byte address 'addr'; false (and stopped) on errors
+    bool read_word( std::uint32_t addr, std::uint32_t& value );
+    // the bits 'mask' of the word at 'addr'
+    bool write_word( std::uint32_t addr, std::uint32_t value,
+                     std::uint32_t mask );
+
+    bool transport( tlm::tlm_command command, std::uint32_t addr,
+                    std::uint32_t& value, std::uint32_t mask );
+
+    // local time of the core, relative to the quantum keeper's
+    sc_core::sc_time local_time() const
+    { return cycle * double( executed ) + stall; }
+
+    // tlm_bw_transport_if methods
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( tlm::tlm_generic_payload&, tlm::tlm_phase&,
+                     sc_core::sc_time& )
+    { return tlm::TLM_COMPLETED; }
+
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64 start,
+                                            sc_dt::uint64 end );
+
+    virtual void end_of_simulation();
+
+    // member variables
+    std::uint32_t    entry;
+    bool             use_dmi;
+    sc_core::sc_time cycle;
+
+    // x0 to x31, and the sink of writes to x0
+    std::uint32_t x[33];
+
+    // decoded pages by page number, and the pages holding any
+    std::unordered_map< std::uint32_t, std::vector<op> > pages;
+    std::vector<bool>                                    decoded;
+
+    // the current batch: instructions left and executed, stalls
+    unsigned long    budget;
+    unsigned long    executed;
+    sc_core::sc_time stall;
+    bool             halted;
+
+    dmi_cache                    dmi_regions;
+    tlm_utils::tlm_quantumkeeper qk;
+
+    // statistics
+    unsigned long long instructions;
+    unsigned long long decodes;
+    unsigned long      loads;
+    unsigned long      stores;
+    unsigned long      transactions; // not through DMI
+    int                exit_code;
+    double             wall;         // s
+}; // rv32_iss
+
+#endif // RV32_ISS_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,47 @@
+#include "settings.h"
+
+#include <fstream>  // std::ifstream
+#include <iostream> // std::cerr, std::endl
+#include <sstream>  // std::stringstream
+
+bool parse_settings( const char* spec, const char* component,
+                     const std::function< bool( const std::string& key,
+                                                const std::string& value ) >& set )
+{
+    std::stringstream settings;
+
+    if( spec[0] == '@' ) {
+        std::ifstream file( spec + 1 );
+        if( !file ) {
+            std::cerr << component << " ERROR: cannot open " << spec + 1
+                      << std::endl;
+            return false;
+        }
+        std::string line;
+        while( std::getline( file, line ) )
+            settings << line.substr( 0, line.find( '#' ) ) << "\n";
+    } else {
+        settings << spec;
+    }
+
+    std::string item;
+    while( settings >> item ) {
+        std::stringstream list( item );
+        std::string       setting;
+        while( std::getline( list, setting, ',' ) ) {
+            if( setting.empty() )
+                continue;
+
+            std::string::size_type eq = setting.find( '=' );
+            if( eq == std::string::npos
+                || !set( setting.substr( 0, eq ), setting.substr( eq + 1 ) ) ) {
+                std::cerr << component << " ERROR: invalid setting '"
+                          << setting << "'" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
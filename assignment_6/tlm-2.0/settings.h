@@ -0,0 +1,18 @@
+#ifndef SETTINGS_H_INCLUDED_
+#define SETTINGS_H_INCLUDED_
+
+#include <functional>
+#include <string>
+
+// Parses a list of 'key=value' settings, separated by commas, blanks
+// or newlines, or read from a file if 'spec' is '@<file>' ('#' starts
+// a comment there).  'set' is called for every setting and returns
+// false for invalid ones.  Errors are reported on std::cerr, prefixed
+// by 'component'.
+bool parse_settings( const char* spec, const char* component,
+                     const std::function< bool( const std::string& key,
+                                                const std::string& value ) >& set );
+
+#endif // SETTINGS_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
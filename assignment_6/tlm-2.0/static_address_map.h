@@ -0,0 +1,105 @@
+#ifndef STATIC_ADDRESS_MAP_H_INCLUDED_
+#define STATIC_ADDRESS_MAP_H_INCLUDED_
+
+#include "address_map.h"
+
+#include <iterator> // std::size
+#include <utility>  // std::index_sequence
+
+// one region of a compile-time memory map
+struct static_region {
+    address_map::address_type start;
+    address_map::address_type end;
+};
+
+// Address decoding for a memory map known at compile time
+//
+// 'Map' provides a constexpr table 'Map::regions' holding the region
+// of slave i at index i, e.g. as generated from a mem_map.txt by
+// gen_mem_map.sh.  The table is checked during compilation.
+//
+// decode() compares the address against every region and sums up the
+// results, which needs no branches and no memory accesses beyond the
+// constants.  Its cost grows with the number of regions, so this is
+// meant for the handful of slaves of a crossbar; large maps are better
+// served by address_map (see bench/static_decode_bench.cpp, the break
+// even is around 8 regions).
+template< typename Map >
+struct static_address_map {
+    typedef address_map::address_type address_type;
+    typedef address_map::index_type   index_type;
+
+    static const index_type npos = address_map::npos;
+
+    static constexpr index_type size()
+    { return std::size( Map::regions ); }
+
+    static index_type decode( address_type addr )
+    { return decode( addr, std::make_index_sequence< size() >() ); }
+
+    index_type operator()( address_type addr ) const
+    { return decode( addr ); }
+
+    static constexpr address_type get_start_address( index_type index )
+    { return index < size() ? Map::regions[index].start : npos; }
+
+    static constexpr address_type get_end_address( index_type index )
+    { return index < size() ? Map::regions[index].end : npos; }
+
+    static constexpr address_type
+    get_local_address( index_type index, address_type addr )
+    { return addr - get_start_address( index ); }
+
+    static constexpr address_type
+    get_global_address( index_type index, address_type addr )
+    { return addr + get_start_address( index ); }
+
+    // same as address_map::get_global_range
+    static void get_global_range( index_type index, address_type& start,
+                                  address_type& end )
+    {
+        address_type last = get_end_address( index ) - get_start_address( index );
+
+        if( start > last ) start = last;
+        if( end > last )   end   = last;
+
+        start = get_global_address( index, start );
+        end   = get_global_address( index, end );
+    }
+
+private:
+
+    // start <= addr <= end, as a single unsigned comparison
+    template< index_type I >
+    static bool contains( address_type addr )
+    {
+        return addr - Map::regions[I].start
+               <= Map::regions[I].end - Map::regions[I].start;
+    }
+
+    // at most one region matches, so the sum is its index plus one,
+    // or zero and hence npos after the subtraction
+    template< index_type... I >
+    static index_type decode( address_type addr, std::index_sequence<I...> )
+    { return ( index_type( 0 ) + ... + ( contains<I>( addr ) * ( I + 1 ) ) ) - 1; }
+
+    static constexpr bool valid()
+    {
+        for( index_type i = 0; i < size(); ++i ) {
+            if( Map::regions[i].end < Map::regions[i].start )
+                return false;
+            for( index_type j = 0; j < i; ++j )
+                if( Map::regions[i].start <= Map::regions[j].end
+                    && Map::regions[j].start <= Map::regions[i].end )
+                    return false;
+        }
+        return true;
+    }
+
+    static_assert( size() > 0, "empty memory map" );
+    static_assert( valid(), "memory map regions are empty or overlap" );
+};
+
+#endif // STATIC_ADDRESS_MAP_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
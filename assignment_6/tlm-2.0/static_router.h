@@ -0,0 +1,127 @@
+#ifndef STATIC_ROUTER_H_INCLUDED_
+#define STATIC_ROUTER_H_INCLUDED_
+
+#include "debug_transport.h"
+#include "static_address_map.h"
+#include "stats.h"
+#include "tracer.h"
+
+#include <vector>
+
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+#include <systemc>
+
+#include <tlm>
+#include <tlm_utils/multi_passthrough_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+
+// Routing component like router, but decoding with a memory map known
+// at compile time (see static_address_map.h), so there is no file to
+// load and no decode cache to maintain
+template< typename Map >
+struct static_router
+: public sc_core::sc_module
+{
+    typedef static_router              this_type;
+    typedef sc_core::sc_module         base_type;
+    typedef static_address_map< Map >  map_type;
+
+    tlm_utils::multi_passthrough_initiator_socket<this_type> init_socket;
+    tlm_utils::simple_target_socket<this_type>               target_socket;
+
+    explicit
+    static_router( sc_core::sc_module_name = sc_core::sc_gen_unique_name("router") )
+    : base_type()
+    , init_socket("init_socket")
+    , target_socket("target_socket")
+    {
+        target_socket.register_b_transport(this, &this_type::b_transport);
+        target_socket.register_get_direct_mem_ptr(this, &this_type::get_direct_mem_ptr);
+        target_socket.register_transport_dbg(this, &this_type::transport_dbg);
+        init_socket.register_invalidate_direct_mem_ptr(this, &this_type::invalidate_direct_mem_ptr);
+    }
+
+private:
+    // Loosely-Timed (Blocking Transport)
+    void b_transport( tlm::tlm_generic_payload& trans,
+                      sc_core::sc_time& delay )
+    {
+        stats_scope initiator( target_stats, trans, delay );
+        trace_scope hop( *this, "route", trans, delay );
+
+        typename map_type::address_type addr = trans.get_address();
+        typename map_type::index_type target = map_type::decode( addr );
+
+        if( target == map_type::npos ) {
+            trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
+            return;
+        }
+        stats_scope slave( init_stats[target], trans, delay );
+
+        // translate to the target address space and reset it afterwards
+        trans.set_address( map_type::get_local_address( target, addr ) );
+        init_socket[target]->b_transport( trans, delay );
+        trans.set_address( addr );
+    }
+
+    // Direct Memory Interface
+    bool get_direct_mem_ptr( tlm::tlm_generic_payload& trans,
+                             tlm::tlm_dmi& dmi )
+    {
+        typename map_type::address_type addr = trans.get_address();
+        typename map_type::index_type target = map_type::decode( addr );
+
+        if( target == map_type::npos )
+            return false;
+
+        trans.set_address( map_type::get_local_address( target, addr ) );
+        bool granted = init_socket[target]->get_direct_mem_ptr( trans, dmi );
+        trans.set_address( addr );
+
+        // translate the region back to the global address space
+        typename map_type::address_type start = dmi.get_start_address();
+        typename map_type::address_type end   = dmi.get_end_address();
+        map_type::get_global_range( target, start, end );
+        dmi.set_start_address( start );
+        dmi.set_end_address( end );
+
+        return granted;
+    }
+
+    void invalidate_direct_mem_ptr( int id, sc_dt::uint64 start,
+                                    sc_dt::uint64 end )
+    {
+        typename map_type::address_type global_start = start;
+        typename map_type::address_type global_end   = end;
+        map_type::get_global_range( id, global_start, global_end );
+
+        target_socket->invalidate_direct_mem_ptr( global_start, global_end );
+    }
+
+    // Debug transport, in zero time (see debug_transport.h)
+    unsigned int transport_dbg( tlm::tlm_generic_payload& trans )
+    {
+        return route_dbg( map_type(), trans,
+            [this]( typename map_type::index_type target,
+                    tlm::tlm_generic_payload& t )
+            { return init_socket[target]->transport_dbg( t ); } );
+    }
+
+    virtual void end_of_elaboration()
+    {
+        sc_assert( init_socket.size() == map_type::size() );
+
+        init_stats.resize( init_socket.size() );
+        register_stats( *this, "target_socket", target_stats );
+        for( unsigned i = 0; i < init_stats.size(); ++i )
+            register_stats( *this, "init_socket", init_stats[i], i );
+    }
+
+    // traffic of our master and per target, see stats.h
+    socket_stats              target_stats;
+    std::vector<socket_stats> init_stats;
+};
+
+#endif // STATIC_ROUTER_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
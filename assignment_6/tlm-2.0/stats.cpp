@@ -0,0 +1,103 @@
+#include "stats.h"
+
+#ifndef NSTATS
+
+#include <algorithm> // std::min
+#include <fstream>   // std::ofstream
+#include <iomanip>   // std::setprecision
+#include <sstream>   // std::stringstream
+#include <vector>
+
+namespace {
+
+struct entry
+{
+    std::string         component;
+    std::string         socket;
+    const socket_stats* stats;
+};
+
+std::vector<entry>& registry()
+{
+    static std::vector<entry> entries;
+    return entries;
+}
+
+double ns( const sc_core::sc_time& t )
+{ return t.to_seconds() * 1e9; }
+
+} // anonymous namespace
+
+void register_stats( const sc_core::sc_object& owner, const char* socket,
+                     const socket_stats& stats, int index )
+{
+    std::stringstream name;
+    name << socket;
+    if( index >= 0 )
+        name << '[' << index << ']';
+
+    entry e = { owner.name(), name.str(), &stats };
+    registry().push_back( e );
+}
+
+bool write_stats_report( const char* prefix )
+{
+    std::string   name( prefix );
+    std::ofstream csv( ( name + ".csv" ).c_str() );
+    std::ofstream json( ( name + ".json" ).c_str() );
+    if( !csv || !json )
+        return false;
+
+    // idle is what is left of the simulated time, the local time of
+    // decoupled initiators may be ahead of it
+    sc_core::sc_time total = sc_core::sc_time_stamp();
+
+    csv << std::fixed << std::setprecision(3);
+    csv << "component,socket,transactions,bytes_read,bytes_written,"
+           "busy_ns,idle_ns,utilization,max_queue\n";
+
+    // SystemC object names need no escaping in JSON
+    json << std::fixed << std::setprecision(3);
+    json << "{\n  \"time_ns\": " << ns( total ) << ",\n  \"sockets\": [";
+
+    const std::vector<entry>& entries = registry();
+    for( unsigned i = 0; i < entries.size(); ++i ) {
+        const socket_stats& s = *entries[i].stats;
+
+        sc_core::sc_time idle = total > s.busy ? total - s.busy
+                                               : sc_core::SC_ZERO_TIME;
+        double utilization = total > sc_core::SC_ZERO_TIME
+                           ? std::min( 1.0, s.busy / total ) : 0.;
+
+        csv << entries[i].component << ',' << entries[i].socket << ','
+            << s.transactions << ',' << s.bytes_read << ','
+            << s.bytes_written << ',' << ns( s.busy ) << ','
+            << ns( idle ) << ',' << utilization << ','
+            << s.max_queue << '\n';
+
+        json << ( i ? "," : "" ) << "\n    { "
+             << "\"component\": \"" << entries[i].component << "\", "
+             << "\"socket\": \"" << entries[i].socket << "\", "
+             << "\"transactions\": " << s.transactions << ", "
+             << "\"bytes_read\": " << s.bytes_read << ", "
+             << "\"bytes_written\": " << s.bytes_written << ", "
+             << "\"busy_ns\": " << ns( s.busy ) << ", "
+             << "\"idle_ns\": " << ns( idle ) << ", "
+             << "\"utilization\": " << utilization << ", "
+             << "\"max_queue\": " << s.max_queue << " }";
+    }
+    json << "\n  ]\n}\n";
+
+    return csv.good() && json.good();
+}
+
+#else // NSTATS
+
+bool write_stats_report( const char* /* prefix unused */ )
+{
+    return false;
+}
+
+#endif // NSTATS
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
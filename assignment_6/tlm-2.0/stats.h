@@ -0,0 +1,113 @@
+#ifndef STATS_H_INCLUDED_
+#define STATS_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+
+#include <string>
+
+// Traffic counters of a single socket
+//
+// Counted are the transactions passing the socket, their payload
+// bytes, the time at least one of them is in flight (busy) and the
+// largest number in flight at once, or queued as reported by the
+// owner.  Times include the annotated delays, so with temporal
+// decoupling they are approximate.  Accesses over DMI bypass the
+// sockets and are not counted.
+//
+// Building with -DNSTATS removes the counters, everything here turns
+// into empty inline functions then.
+struct socket_stats
+{
+#ifndef NSTATS
+    socket_stats()
+    : transactions(), bytes_read(), bytes_written()
+    , busy(), max_queue(), in_flight(), busy_since()
+    {}
+
+    void begin( const tlm::tlm_generic_payload& trans,
+                const sc_core::sc_time& delay )
+    {
+        ++transactions;
+        if( trans.is_read() )
+            bytes_read += trans.get_data_length();
+        else if( trans.is_write() )
+            bytes_written += trans.get_data_length();
+
+        if( !in_flight++ )
+            busy_since = sc_core::sc_time_stamp() + delay;
+        queue( in_flight );
+    }
+
+    void end( const sc_core::sc_time& delay )
+    {
+        sc_core::sc_time now = sc_core::sc_time_stamp() + delay;
+        if( !--in_flight && now > busy_since )
+            busy += now - busy_since;
+    }
+
+    void queue( unsigned depth )
+    {
+        if( depth > max_queue )
+            max_queue = depth;
+    }
+
+    unsigned long      transactions;
+    unsigned long long bytes_read;
+    unsigned long long bytes_written;
+    sc_core::sc_time   busy;
+    unsigned           max_queue;
+
+private:
+    unsigned           in_flight;
+    sc_core::sc_time   busy_since;
+#else
+    void begin( const tlm::tlm_generic_payload&, const sc_core::sc_time& ) {}
+    void end( const sc_core::sc_time& ) {}
+    void queue( unsigned ) {}
+#endif
+};
+
+// counts a transaction as in flight for the lifetime of the scope,
+// i.e. while it is forwarded through the socket
+struct stats_scope
+{
+#ifndef NSTATS
+    stats_scope( socket_stats& stats, const tlm::tlm_generic_payload& trans,
+                 const sc_core::sc_time& delay )
+    : stats( stats ), delay( delay )
+    { stats.begin( trans, delay ); }
+
+    ~stats_scope()
+    { stats.end( delay ); }
+
+private:
+    socket_stats&           stats;
+    const sc_core::sc_time& delay;
+#else
+    stats_scope( socket_stats&, const tlm::tlm_generic_payload&,
+                 const sc_core::sc_time& )
+    {}
+#endif
+};
+
+// adds the counters of 'socket' of 'owner' (of its index-th binding,
+// for multi-sockets) to the report; they have to stay in place until
+// the report is written
+#ifndef NSTATS
+void register_stats( const sc_core::sc_object& owner, const char* socket,
+                     const socket_stats& stats, int index = -1 );
+#else
+inline void register_stats( const sc_core::sc_object&, const char*,
+                            const socket_stats&, int = -1 )
+{}
+#endif
+
+// writes the counters of all registered sockets to <prefix>.csv and
+// <prefix>.json, returns false if a file cannot be written or the
+// counters have been compiled out
+bool write_stats_report( const char* prefix );
+
+#endif // STATS_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
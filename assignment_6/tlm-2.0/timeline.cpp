@@ -0,0 +1,41 @@
+#include "timeline.h"
+
+#include <iterator> // std::prev
+
+sc_core::sc_time timeline::find( const sc_core::sc_time& at,
+                                 const sc_core::sc_time& length ) const
+{
+    // skip the reservations in the way
+    sc_core::sc_time             start = at;
+    interval_map::const_iterator next  = intervals.upper_bound( start );
+    if( next != intervals.begin() && std::prev( next )->second > start )
+        start = std::prev( next )->second;
+    while( next != intervals.end() && next->first < start + length )
+        start = ( next++ )->second;
+    return start;
+}
+
+sc_core::sc_time timeline::reserve( const sc_core::sc_time& at,
+                                    const sc_core::sc_time& length )
+{
+    if( length == sc_core::SC_ZERO_TIME )
+        return at;
+
+    // no access arrives before the current time
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    while( !intervals.empty() && intervals.begin()->second <= now )
+        intervals.erase( intervals.begin() );
+
+    sc_core::sc_time       start = find( at, length );
+    interval_map::iterator next  = intervals.upper_bound( start );
+    reserved += length;
+
+    // extend the reservation just before, streams keep the map short
+    if( next != intervals.begin() && std::prev( next )->second == start )
+        std::prev( next )->second = start + length;
+    else
+        intervals.emplace_hint( next, start, start + length );
+    return start;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,41 @@
+#ifndef TIMELINE_H_INCLUDED_
+#define TIMELINE_H_INCLUDED_
+
+#include <systemc>
+
+#include <map>
+
+// Busy intervals of a resource in simulated time
+//
+// Reservations are disjoint intervals, merged when they touch.  As
+// temporally decoupled initiators arrive out of order, a reservation
+// takes the earliest gap that fits, not necessarily the end of the
+// timeline.  Intervals that ended before the current kernel time are
+// dropped, no access can arrive before it.
+class timeline
+{
+public:
+    timeline() : intervals(), reserved() {}
+
+    // start of the earliest gap of 'length' at or after 'at'
+    sc_core::sc_time find( const sc_core::sc_time& at,
+                           const sc_core::sc_time& length ) const;
+
+    // reserves the earliest gap, returns its start
+    sc_core::sc_time reserve( const sc_core::sc_time& at,
+                              const sc_core::sc_time& length );
+
+    // total time reserved so far
+    const sc_core::sc_time& busy() const
+    { return reserved; }
+
+private:
+    typedef std::map< sc_core::sc_time, sc_core::sc_time > interval_map;
+
+    interval_map     intervals; // start to end
+    sc_core::sc_time reserved;
+};
+
+#endif // TIMELINE_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
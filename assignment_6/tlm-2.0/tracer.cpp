@@ -0,0 +1,133 @@
+#include "tracer.h"
+
+#include <algorithm> // std::min
+#include <string>    // std::to_string
+
+namespace {
+
+// events are written in blocks of this size
+const std::size_t block_size = 1 << 20;
+
+double us( const sc_core::sc_time& t )
+{ return t.to_seconds() * 1e6; }
+
+} // anonymous namespace
+
+tracer& tracer::instance()
+{
+    static tracer the_tracer;
+    return the_tracer;
+}
+
+tracer::tracer()
+: file( NULL )
+, buffer()
+, first( true )
+, ids()
+, threads()
+{}
+
+tracer::~tracer()
+{
+    close();
+}
+
+bool tracer::open( const char* filename )
+{
+    close();
+
+    file = std::fopen( filename, "w" );
+    if( !file )
+        return false;
+
+    buffer.reserve( block_size + 512 );
+    buffer = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    first  = true;
+    threads.clear();
+    return true;
+}
+
+void tracer::close()
+{
+    if( !file )
+        return;
+
+    buffer += "\n]}\n";
+    flush();
+    std::fclose( file );
+    file = NULL;
+}
+
+void tracer::complete( const sc_core::sc_object& where, const char* what,
+                       unsigned long long id,
+                       const sc_core::sc_time& start,
+                       const sc_core::sc_time& end )
+{
+    if( !file )
+        return;
+
+    unsigned tid = thread_of( where );
+    double   dur = end > start ? us( end - start ) : 0.;
+
+    char event[256];
+    int  n = std::snprintf( event, sizeof(event),
+        "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, "
+        "\"ts\": %.6f, \"dur\": %.6f, \"args\": {\"id\": %llu}}",
+        first ? "" : ",", what, tid, us( start ), dur, id );
+    if( n > 0 )
+        buffer.append( event, std::min( std::size_t( n ), sizeof(event) - 1 ) );
+    first = false;
+
+    if( buffer.size() >= block_size )
+        flush();
+}
+
+// one row per component, named by a metadata event
+unsigned tracer::thread_of( const sc_core::sc_object& where )
+{
+    std::map<const sc_core::sc_object*, unsigned>::iterator it
+        = threads.find( &where );
+    if( it != threads.end() )
+        return it->second;
+
+    unsigned tid = threads.size() + 1;
+    threads[&where] = tid;
+
+    // SystemC object names need no escaping in JSON
+    buffer += first ? "\n" : ",\n";
+    buffer += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": ";
+    buffer += std::to_string( tid );
+    buffer += ", \"args\": {\"name\": \"";
+    buffer += where.name();
+    buffer += "\"}}";
+    first = false;
+    return tid;
+}
+
+void tracer::flush()
+{
+    if( file && !buffer.empty() )
+        std::fwrite( buffer.data(), 1, buffer.size(), file );
+    buffer.clear();
+}
+
+void trace_scope::begin( tlm::tlm_generic_payload& trans, bool issue )
+{
+    trace_extension* ext = NULL;
+    trans.get_extension( ext );
+
+    if( issue ) {
+        if( !ext ) {
+            ext = new trace_extension;
+            trans.set_extension( ext );
+        }
+        ext->id = tracer::instance().next_id();
+    }
+
+    if( ext ) {
+        id    = ext->id;
+        start = sc_core::sc_time_stamp() + delay;
+    }
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,104 @@
+#ifndef TRACER_H_INCLUDED_
+#define TRACER_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+
+#include <cstdio>  // std::FILE
+#include <map>
+#include <string>
+
+// Transaction tracer writing Chrome trace-event JSON
+//
+// Open a trace file to enable it (main's -t option); the resulting
+// file loads into chrome://tracing or ui.perfetto.dev.  Every hop of
+// a transaction becomes a complete event ("ph": "X") on the row of
+// the component it passes, from the time it arrives to the time it
+// is passed back, both including the annotated delays.  All events of
+// one transaction carry the same "args.id", assigned at issue and
+// kept in a trace_extension.
+//
+// Events are collected in memory and written in large blocks.
+class tracer
+{
+public:
+    static tracer& instance();
+
+    bool open( const char* filename );
+    void close();
+
+    bool is_open() const
+    { return file != NULL; }
+
+    // new transaction id, ids start at 1
+    unsigned long long next_id()
+    { return ++ids; }
+
+    void complete( const sc_core::sc_object& where, const char* what,
+                   unsigned long long id,
+                   const sc_core::sc_time& start,
+                   const sc_core::sc_time& end );
+
+private:
+    tracer();
+    ~tracer();
+
+    unsigned thread_of( const sc_core::sc_object& where );
+    void     flush();
+
+    std::FILE*                              file;
+    std::string                             buffer;
+    bool                                    first;
+    unsigned long long                      ids;
+    std::map<const sc_core::sc_object*, unsigned> threads;
+};
+
+// id of the traced transaction, a sticky extension that is reused
+// with pooled payloads
+struct trace_extension
+: tlm::tlm_extension<trace_extension>
+{
+    trace_extension() : id() {}
+
+    virtual tlm::tlm_extension_base* clone() const
+    { return new trace_extension( *this ); }
+    virtual void copy_from( tlm::tlm_extension_base const & that )
+    { id = static_cast< trace_extension const & >( that ).id; }
+
+    unsigned long long id;
+};
+
+// traces the hop 'what' at 'where' for the lifetime of the scope; an
+// 'issue' scope starts a new transaction, others trace only payloads
+// carrying an id already
+struct trace_scope
+{
+    trace_scope( const sc_core::sc_object& where, const char* what,
+                 tlm::tlm_generic_payload& trans,
+                 const sc_core::sc_time& delay, bool issue = false )
+    : where( where ), what( what ), delay( delay ), id()
+    {
+        if( tracer::instance().is_open() )
+            begin( trans, issue );
+    }
+
+    ~trace_scope()
+    {
+        if( id )
+            tracer::instance().complete( where, what, id, start,
+                                         sc_core::sc_time_stamp() + delay );
+    }
+
+private:
+    void begin( tlm::tlm_generic_payload& trans, bool issue );
+
+    const sc_core::sc_object& where;
+    const char*               what;
+    const sc_core::sc_time&   delay;
+    unsigned long long        id;
+    sc_core::sc_time          start;
+};
+
+#endif // TRACER_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
@@ -0,0 +1,275 @@
+
+#include "traffic_generator.h"
+#include "settings.h"
+#include "tracer.h"
+
+#include <algorithm> // std::min, std::max, std::swap
+#include <iostream>  // std::cout, std::endl
+#include <sstream>   // std::stringstream
+
+traffic_config::traffic_config()
+: pattern( sequential )
+, stride( 16 )
+, hot( 10 )
+, share( 90 )
+, reads( 50 )
+, burst_min( 1 )
+, burst_max( 1 )
+, count( 1000 )
+, interval( 0 )
+, think( 0 )
+, seed( 1 )
+{}
+
+bool traffic_config::parse( const char* spec )
+{
+    return parse_settings( spec, "Traffic",
+        [this]( const std::string& key, const std::string& value )
+        { return set( key, value ); } );
+}
+
+bool traffic_config::set( const std::string& key, const std::string& value )
+{
+    std::stringstream in( value );
+    char              dash = 0;
+    bool              ok   = true;
+
+    if( key == "pattern" ) {
+        if( value == "sequential" )    pattern = sequential;
+        else if( value == "strided" )  pattern = strided;
+        else if( value == "random" )   pattern = random;
+        else if( value == "hotspot" )  pattern = hotspot;
+        else if( value == "chase" )    pattern = chase;
+        else return false;
+        return true;
+    } else if( key == "burst" ) {
+        ok = bool( in >> burst_min );
+        burst_max = burst_min;
+        if( ok && in >> dash )
+            ok = dash == '-' && ( in >> burst_max ) && burst_max >= burst_min;
+        ok = ok && burst_min > 0;
+    } else if( key == "stride" ) {
+        ok = ( in >> stride ) && stride > 0;
+    } else if( key == "hot" ) {
+        ok = ( in >> hot ) && hot > 0 && hot <= 100;
+    } else if( key == "share" ) {
+        ok = ( in >> share ) && share <= 100;
+    } else if( key == "reads" ) {
+        ok = ( in >> reads ) && reads <= 100;
+    } else if( key == "count" ) {
+        ok = bool( in >> count );
+    } else if( key == "interval" ) {
+        ok = ( in >> interval ) && interval >= 0;
+    } else if( key == "think" ) {
+        ok = ( in >> think ) && think >= 0;
+    } else if( key == "seed" ) {
+        ok = bool( in >> seed );
+    } else {
+        return false;
+    }
+
+    // no trailing garbage
+    return ok && ( in >> std::ws ).eof();
+}
+
+traffic_generator::traffic_generator( sc_core::sc_module_name /* unused */,
+                                      unsigned start_addr, unsigned end_addr,
+                                      const traffic_config& config )
+: base_type()
+, init_socket( "init_socket" )
+, start( start_addr )
+, end( end_addr )
+, config( config )
+, random()
+, position()
+, qk()
+, pool( config.burst_max * sizeof(unsigned), this )
+, reads(), writes(), errors(), late(), bytes()
+, latency_sum(), latency_max(), started(), finished()
+{
+    // same seed, but a different sequence per instance (FNV-1a)
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    for( const char* c = name(); *c; ++c )
+        hash = ( hash ^ static_cast< unsigned char >( *c ) ) * 0x100000001B3ull;
+    random.seed( config.seed ^ hash );
+
+    SC_THREAD( action );
+    init_socket.bind( *this );
+}
+
+void traffic_generator::action()
+{
+    tlm::tlm_generic_payload& trans = *pool.allocate();
+    unsigned* data = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
+
+    wait( 10, sc_core::SC_NS );
+    qk.reset();
+
+    if( config.pattern == traffic_config::chase )
+        setup_chase( trans );
+
+    const sc_core::sc_time interval( config.interval, sc_core::SC_NS );
+    const sc_core::sc_time think( config.think, sc_core::SC_NS );
+
+    started = qk.get_current_time();
+    sc_core::sc_time next_issue = started;
+    unsigned         last_data  = 0;
+
+    for( unsigned n = 0; n < config.count; ++n ) {
+        unsigned words = next_burst();
+        unsigned addr  = next_address( words, last_data );
+        bool     read  = config.pattern == traffic_config::chase
+                         || random.percent( config.reads );
+
+        // open loop: issue on schedule, unless we are running behind
+        if( interval != sc_core::SC_ZERO_TIME ) {
+            if( qk.get_current_time() < next_issue )
+                qk.inc( next_issue - qk.get_current_time() );
+            else if( n )
+                ++late;
+            next_issue += interval;
+        }
+
+        if( read ) {
+            trans.set_command( tlm::TLM_READ_COMMAND );
+        } else {
+            trans.set_command( tlm::TLM_WRITE_COMMAND );
+            for( unsigned i = 0; i < words; ++i )
+                data[i] = random();
+        }
+        trans.set_address( addr );
+        trans.set_data_length( words * sizeof(unsigned) );
+        trans.set_streaming_width( words * sizeof(unsigned) );
+        trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+        sc_core::sc_time issued = qk.get_current_time();
+        sc_core::sc_time delay  = sc_core::SC_ZERO_TIME;
+        {
+            trace_scope scope( *this, "transaction", trans, delay, true );
+            init_socket->b_transport( trans, delay );
+        }
+
+        // includes the time spent waiting inside b_transport
+        sc_core::sc_time latency = qk.get_current_time() + delay - issued;
+        latency_sum += latency;
+        latency_max  = std::max( latency_max, latency );
+
+        if( trans.is_response_error() )
+            ++errors;
+        if( read ) {
+            ++reads;
+            last_data = data[0];
+        } else {
+            ++writes;
+        }
+        bytes += trans.get_data_length();
+
+        qk.inc( delay );
+        if( interval == sc_core::SC_ZERO_TIME )
+            qk.inc( think );
+        if( qk.need_sync() )
+            qk.sync();
+    }
+
+    qk.sync();
+    finished = sc_core::sc_time_stamp();
+    trans.release();
+}
+
+void traffic_generator::setup_chase( tlm::tlm_generic_payload& trans )
+{
+    unsigned* data  = reinterpret_cast< unsigned* >( trans.get_data_ptr() );
+    unsigned  range = end - start + 1;
+
+    // Sattolo's algorithm: 'next' holds a single cycle through all words
+    std::vector<unsigned> next( range );
+    for( unsigned i = 0; i < range; ++i )
+        next[i] = i;
+    for( unsigned i = range - 1; i > 0; --i )
+        std::swap( next[i], next[ random.below( i ) ] );
+
+    trans.set_command( tlm::TLM_WRITE_COMMAND );
+    for( unsigned offset = 0; offset < range; offset += config.burst_max ) {
+        unsigned words = std::min( config.burst_max, range - offset );
+        std::copy( &next[offset], &next[offset] + words, data );
+
+        trans.set_address( start + offset );
+        trans.set_data_length( words * sizeof(unsigned) );
+        trans.set_streaming_width( words * sizeof(unsigned) );
+        trans.set_response_status( tlm::TLM_INCOMPLETE_RESPONSE );
+
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        init_socket->b_transport( trans, delay );
+        qk.inc( delay );
+        if( qk.need_sync() )
+            qk.sync();
+    }
+    qk.sync();
+}
+
+unsigned traffic_generator::next_burst()
+{
+    unsigned words = config.burst_min
+                   + random.below( config.burst_max - config.burst_min + 1 );
+    return std::min( words, end - start + 1 );
+}
+
+unsigned traffic_generator::next_address( unsigned words, unsigned last_data )
+{
+    // offsets where a burst of 'words' still fits into the range
+    unsigned span   = end - start + 1 - words + 1;
+    unsigned offset = 0;
+
+    switch( config.pattern ) {
+    case traffic_config::sequential:
+        offset    = position % span;
+        position += words;
+        break;
+
+    case traffic_config::strided:
+        offset    = position % span;
+        position += config.stride;
+        break;
+
+    case traffic_config::random:
+        offset = random.below( span );
+        break;
+
+    case traffic_config::hotspot: {
+        unsigned hot = std::max( 1u, unsigned( std::uint64_t( span ) * config.hot / 100 ) );
+        if( hot >= span || random.percent( config.share ) )
+            offset = random.below( hot );
+        else
+            offset = hot + random.below( span - hot );
+        break;
+    }
+
+    case traffic_config::chase:
+        offset = last_data % span;
+        break;
+    }
+    return start + offset;
+}
+
+void traffic_generator::end_of_simulation()
+{
+    unsigned long    transactions = reads + writes;
+    sc_core::sc_time elapsed      = finished - started;
+
+    std::cout << name() << ": "
+              << reads << " reads, " << writes << " writes, "
+              << bytes << " bytes, " << errors << " errors, "
+              << late << " late issues" << std::endl;
+    if( !transactions )
+        return;
+
+    std::cout << name() << " latency: "
+              << latency_sum / double( transactions ) << " average, "
+              << latency_max << " max" << std::endl;
+    if( elapsed > sc_core::SC_ZERO_TIME )
+        std::cout << name() << " throughput: "
+                  << bytes / ( elapsed.to_seconds() * 1e9 ) << " bytes/ns"
+                  << std::endl;
+}
+
+/* vim: set ts=4 sw=4 tw=72 et :*/
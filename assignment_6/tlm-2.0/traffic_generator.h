@@ -0,0 +1,141 @@
+#ifndef TRAFFIC_GENERATOR_H_INCLUDED_
+#define TRAFFIC_GENERATOR_H_INCLUDED_
+
+#include <systemc>
+#include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+
+#include "payload_pool.h"
+#include "prng.h"
+
+#include <string>
+#include <vector>
+
+// Configuration of a traffic_generator
+//
+// Read from a list of 'key=value' settings, separated by commas,
+// blanks or newlines ('#' starts a comment):
+//
+//   pattern=<p>  sequential, strided, random, hotspot or chase
+//                (default: sequential)
+//   stride=<n>   words between accesses of 'strided' (default: 16)
+//   hot=<n>      size of the hotspot in percent of the range
+//                (default: 10)
+//   share=<n>    percentage of accesses to the hotspot (default: 90)
+//   reads=<n>    percentage of reads (default: 50)
+//   burst=<n>[-<m>] words per transaction, or a range to pick from
+//                uniformly (default: 1)
+//   count=<n>    transactions to issue (default: 1000)
+//   interval=<ns> open loop: issue every <ns>, regardless of the
+//                completion of the previous one (default: 0, closed
+//                loop)
+//   think=<ns>   closed loop: time between the completion of one
+//                transaction and the issue of the next (default: 0)
+//   seed=<n>     seed of the generator's random numbers (default: 1)
+//
+// 'chase' follows pointers: every access is a read, and the first
+// word it returns selects the next address.  The range is set up with
+// a single random cycle of pointers before the measured traffic.
+struct traffic_config
+{
+    enum pattern_type
+    {
+        sequential,
+        strided,
+        random,
+        hotspot,
+        chase
+    };
+
+    traffic_config();
+
+    // 'spec' is a list of settings, or '@<file>' to read them from a
+    // file; returns false (with a message) on errors
+    bool parse( const char* spec );
+
+    pattern_type pattern;
+    unsigned     stride;
+    unsigned     hot;
+    unsigned     share;
+    unsigned     reads;
+    unsigned     burst_min;
+    unsigned     burst_max;
+    unsigned     count;
+    double       interval;
+    double       think;
+    unsigned     seed;
+
+private:
+    bool set( const std::string& key, const std::string& value );
+};
+
+// Loosely-timed initiator issuing synthetic traffic to [start,end]
+//
+// All accesses go through b_transport, DMI would bypass the
+// interconnect under test.  The issue, completion and latency
+// statistics are printed at the end of simulation.
+struct traffic_generator
+: public sc_core::sc_module
+, protected tlm::tlm_bw_transport_if<>
+{
+    typedef traffic_generator  this_type;
+    typedef sc_core::sc_module base_type;
+
+    SC_HAS_PROCESS(this_type);
+    traffic_generator( sc_core::sc_module_name,
+                       unsigned start_addr, unsigned end_addr,
+                       const traffic_config& config );
+
+    tlm::tlm_initiator_socket<> init_socket;
+
+private:
+    void action();
+
+    // writes a random cycle of pointers for the 'chase' pattern
+    void setup_chase( tlm::tlm_generic_payload& trans );
+
+    // address of the next transaction of 'words' words
+    unsigned next_address( unsigned words, unsigned last_data );
+    unsigned next_burst();
+
+    virtual void end_of_simulation();
+
+    // tlm_bw_transport_if methods, not used
+    virtual tlm::tlm_sync_enum
+    nb_transport_bw( tlm::tlm_generic_payload&, tlm::tlm_phase&,
+                     sc_core::sc_time& )
+    { return tlm::TLM_COMPLETED; }
+
+    virtual void invalidate_direct_mem_ptr( sc_dt::uint64, sc_dt::uint64 )
+    {}
+
+    // member variables
+    unsigned       start;
+    unsigned       end;
+    traffic_config config;
+    prng           random;
+
+    // position of the sequential and strided patterns
+    unsigned       position;
+
+    // local time for temporal decoupling
+    tlm_utils::tlm_quantumkeeper qk;
+
+    // payloads (and data buffers) for our transactions
+    payload_pool pool;
+
+    // statistics
+    unsigned long      reads;
+    unsigned long      writes;
+    unsigned long      errors;
+    unsigned long      late;   // open loop issues behind schedule
+    unsigned long long bytes;
+    sc_core::sc_time   latency_sum;
+    sc_core::sc_time   latency_max;
+    sc_core::sc_time   started;
+    sc_core::sc_time   finished;
+}; // traffic_generator
+
+#endif // TRAFFIC_GENERATOR_H_INCLUDED_
+
+/* vim: set ts=4 sw=4 tw=72 et :*/